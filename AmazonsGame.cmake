@@ -57,6 +57,72 @@ setAppIcon(${AMAZONS_NAME} ${CMAKE_CURRENT_LIST_DIR})
 setIDEPropertiesForGUIExecutable(${AMAZONS_NAME} ${CMAKE_CURRENT_LIST_DIR})
 setPlatformDLLPath(${AMAZONS_NAME})
 
+# --- AVX2 kernels (evaluation network); off by default so the build runs on any x86-64
+option(AMAZONS_AVX2 "Compile the engine for CPUs with AVX2" OFF)
+if(AMAZONS_AVX2)
+    if(MSVC)
+        target_compile_options(${AMAZONS_NAME} PRIVATE /arch:AVX2)
+    else()
+        target_compile_options(${AMAZONS_NAME} PRIVATE -mavx2)
+    endif()
+endif()
+
+# --- Offline engine data generators (optional)
+option(AMAZONS_BUILD_TOOLS "Build the offline engine data generators" OFF)
+if(AMAZONS_BUILD_TOOLS)
+    find_package(Threads REQUIRED)
+    add_executable(RegionDbGen ${CMAKE_CURRENT_LIST_DIR}/tools/RegionDbGen.cpp)
+    target_include_directories(RegionDbGen PRIVATE ${CMAKE_CURRENT_LIST_DIR}/src)
+    target_link_libraries(RegionDbGen PRIVATE Threads::Threads)
+
+    set(AMAZONS_REGION_DB ${CMAKE_CURRENT_LIST_DIR}/res/data/regions.db)
+    add_custom_command(OUTPUT ${AMAZONS_REGION_DB}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${CMAKE_CURRENT_LIST_DIR}/res/data
+        COMMAND RegionDbGen ${AMAZONS_REGION_DB}
+        DEPENDS RegionDbGen
+        COMMENT "Generating region endgame database")
+    add_custom_target(RegionDatabase DEPENDS ${AMAZONS_REGION_DB})
+
+    add_executable(BookGen ${CMAKE_CURRENT_LIST_DIR}/tools/BookGen.cpp)
+    target_include_directories(BookGen PRIVATE ${CMAKE_CURRENT_LIST_DIR}/src)
+    target_link_libraries(BookGen PRIVATE Threads::Threads)
+
+    set(AMAZONS_OPENING_BOOK ${CMAKE_CURRENT_LIST_DIR}/res/data/opening.book)
+    add_custom_command(OUTPUT ${AMAZONS_OPENING_BOOK}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${CMAKE_CURRENT_LIST_DIR}/res/data
+        COMMAND BookGen ${AMAZONS_OPENING_BOOK}
+        DEPENDS BookGen
+        COMMENT "Building opening book from self-play")
+    add_custom_target(OpeningBook DEPENDS ${AMAZONS_OPENING_BOOK})
+
+    # Solving 6x6 takes far longer than a build; run it by hand and copy solved6.book to res/data
+    add_executable(Solve6x6 ${CMAKE_CURRENT_LIST_DIR}/tools/Solve6x6.cpp)
+    target_include_directories(Solve6x6 PRIVATE ${CMAKE_CURRENT_LIST_DIR}/src)
+    target_link_libraries(Solve6x6 PRIVATE Threads::Threads)
+
+    # Self-play labelling and weight fitting; copy the resulting eval.weights to res/data
+    add_executable(EvalTune ${CMAKE_CURRENT_LIST_DIR}/tools/EvalTune.cpp)
+    target_include_directories(EvalTune PRIVATE ${CMAKE_CURRENT_LIST_DIR}/src)
+    target_link_libraries(EvalTune PRIVATE Threads::Threads)
+
+    # Headless matches between engine settings, e.g. EngineMatch hard hard-mcts 10
+    add_executable(EngineMatch ${CMAKE_CURRENT_LIST_DIR}/tools/EngineMatch.cpp)
+    target_include_directories(EngineMatch PRIVATE ${CMAKE_CURRENT_LIST_DIR}/src)
+    target_link_libraries(EngineMatch PRIVATE Threads::Threads)
+
+    # Fast paths against plain recomputation, with the engine's instruction set
+    add_executable(EngineCheck ${CMAKE_CURRENT_LIST_DIR}/tools/EngineCheck.cpp)
+    target_include_directories(EngineCheck PRIVATE ${CMAKE_CURRENT_LIST_DIR}/src)
+    target_link_libraries(EngineCheck PRIVATE Threads::Threads)
+    if(AMAZONS_AVX2)
+        if(MSVC)
+            target_compile_options(EngineCheck PRIVATE /arch:AVX2)
+        else()
+            target_compile_options(EngineCheck PRIVATE -mavx2)
+        endif()
+    endif()
+endif()
+
 # Linux icon installation
 if(UNIX AND NOT APPLE)
     set(ICON_SIZES 16 32 48 128 256)
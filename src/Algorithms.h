@@ -1,14 +1,30 @@
 #pragma once
 
+#include "BatchEval.h"
+#include "BoardSolver.h"
+#include "DistanceMap.h"
+#include "EvalCache.h"
+#include "EvalWeights.h"
 #include "GameState.h"
+#include "OpeningBook.h"
 #include "Rules.h"
+#include "ProofSearch.h"
+#include "SearchPosition.h"
+#include "TranspositionTable.h"
+#include "ThreadPool.h"
+#include "WorkStealing.h"
+#include <array>
 #include <vector>
-#include <queue>
 #include <algorithm>
 #include <limits>
 #include <cmath>
 #include <atomic>
+#include <chrono>
 #include <stdexcept>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <numeric>
 
 struct SearchCanceled : public std::exception {
     const char* what() const noexcept override {
@@ -16,6 +32,13 @@ struct SearchCanceled : public std::exception {
     }
 };
 
+// Thrown inside the search when the time budget runs out; getBestMove keeps the last finished iteration
+struct SearchTimedOut : public std::exception {
+    const char* what() const noexcept override {
+        return "search time budget exhausted";
+    }
+};
+
 namespace detail {
 
     // Helper: Switches player without relying on other files
@@ -23,302 +46,1383 @@ namespace detail {
         return (p == Player::White) ? Player::Black : Player::White;
     }
 
-    // WORKAROUND: Scans the board to find queens since GameState::queens is private.
-    inline std::vector<Position> scanForQueens(const GameState& state, Player player) {
-        std::vector<Position> queens;
-        const auto& board = state.board();
-        int dim = board.dimension();
-        TileContent target = (player == Player::White) ? TileContent::WhiteQueen : TileContent::BlackQueen;
-
-        for (int r = 0; r < dim; ++r) {
-            for (int c = 0; c < dim; ++c) {
-                if (board.getTile(r, c) == target) {
-                    queens.push_back({ r, c });
+    // Legal moves of 'player', counted up to a sample of 48; counts in place, without building moves
+    inline int mobilityCount(const GameState& state, Player player) {
+        constexpr int kMobilitySample = 48;
+        const auto& tiles = state.board().tiles();
+        int dim = state.board().dimension();
+        int count = 0;
+        for (const auto& queen : state.queenPositions(player)) {
+            int from = queen.row * dim + queen.col;
+            forEachReachableSquare(tiles, dim, from, -1, [&](int to) {
+                if (count < kMobilitySample) {
+                    forEachReachableSquare(tiles, dim, to, from, [&](int) { ++count; });
                 }
+            });
+            if (count >= kMobilitySample) {
+                break;
             }
         }
-        return queens;
+        return std::min(count, kMobilitySample);
     }
 
-    inline int mobilityCount(const GameState& state, Player player) {
-        constexpr std::size_t kMobilitySample = 48;
-        auto moves = generateMovesForPlayer(state, player, kMobilitySample);
-        return static_cast<int>(moves.size());
+    // Territory by who reaches each empty square first, under the queen and the king metric. Squares
+    // both sides reach equally fast lean a little towards the side to move. While the armies are in
+    // contact the king metric and the closeness terms matter as well; once the board has split into
+    // regions only who owns what (queen metric) is left. Roughly in squares, from 'player's view.
+    inline int territoryScore(const GameState& state, Player player) {
+        const auto& tiles = state.board().tiles();
+        int dim = state.board().dimension();
+        distance::Occupancy occupancy(tiles, dim);
+        distance::SideMaps queenMaps, kingMaps;
+        distance::fill(occupancy, distance::Metric::Queen, queenMaps);
+        distance::fill(occupancy, distance::Metric::King, kingMaps);
+        const auto& ownQueen = queenMaps.of(player);
+        const auto& otherQueen = queenMaps.of(getOpponent(player));
+        const auto& ownKing = kingMaps.of(player);
+        const auto& otherKing = kingMaps.of(getOpponent(player));
+
+        // Adds 'mine' vs 'theirs' to the owned and tied counts
+        auto own = [](std::uint8_t mine, std::uint8_t theirs, int& owned, int& tied) {
+            if (mine == theirs) {
+                tied += mine != distance::kUnreached;
+            }
+            else {
+                owned += mine < theirs ? 1 : -1;
+            }
+        };
+        using Sums = distance::TerritorySums;
+
+        Sums sums;
+        for (int square = 0; square < dim * dim; ++square) {
+            auto idx = static_cast<std::size_t>(square);
+            if (tiles[idx] != TileContent::Empty) {
+                continue;
+            }
+            ++sums.empty;
+            own(ownQueen[idx], otherQueen[idx], sums.queenOwned, sums.queenTied);
+            own(ownKing[idx], otherKing[idx], sums.kingOwned, sums.kingTied);
+            sums.queenCloseness += Sums::closeness(ownQueen[idx]) - Sums::closeness(otherQueen[idx]);
+            sums.kingLead += std::clamp(otherKing[idx] - ownKing[idx], -Sums::kKingDistanceCap, Sums::kKingDistanceCap);
+            if (ownQueen[idx] != distance::kUnreached && otherQueen[idx] != distance::kUnreached) {
+                sums.contact += Sums::closeness(std::abs(ownQueen[idx] - otherQueen[idx]));
+            }
+        }
+        return sums.score(state.currentPlayer() == player);
     }
 
-    inline std::size_t floodFillReachableTiles(const GameState& state, const Position& start) {
-        const auto& board = state.board();
-        int dim = board.dimension();
+    // NEW: Spatial Influence (Used in Medium/Hard)
+    // Per queen: 10 points in the centre down to 5 in a corner, plus a quarter point per square it
+    // reaches so the spot isn't a trap. Read off the incremental terms, in their fixed point.
+    inline int spatialInfluenceScore(const IncrementalEval& terms, Player player) {
+        constexpr int kOne = IncrementalEval::kCentralityOne;
+        auto positionalValue = [&](Player side) { return terms.mobility(side) * (kOne / 4) + terms.centrality(side) * 10; };
+        return (positionalValue(player) - positionalValue(getOpponent(player))) / kOne;
+    }
 
-        if (!board.isInsideBoard(start.row, start.col)) {
-            return 0;
+    inline int evaluateTerminal(Player winner, Player perspective) {
+        if (winner == perspective) {
+            return std::numeric_limits<int>::max() / 4;
         }
+        if (winner == getOpponent(perspective)) {
+            return std::numeric_limits<int>::min() / 4;
+        }
+        return 0;
+    }
 
-        Board workingBoard = board;
-        workingBoard.setTile(start.row, start.col, TileContent::Empty);
+    inline int evaluateTerminal(const GameState& state, Player perspective) {
+        if (!state.isFinished()) return 0;
+        return evaluateTerminal(state.winner(), perspective);
+    }
 
-        std::vector<bool> visited(static_cast<std::size_t>(dim * dim), false);
-        auto indexOf = [dim](int row, int col) {
-            return static_cast<std::size_t>(row * dim + col);
-        };
+    inline bool isTerminal(const GameState& state) {
+        if (state.isFinished()) return true;
+        return !hasAnyLegalMove(state, state.currentPlayer());
+    }
+}
 
-        std::queue<Position> frontier;
-        frontier.push(start);
-        visited[indexOf(start.row, start.col)] = true;
-        std::size_t count = 1;
+// Calls visit(profile) with the profile of 'difficulty'; the one runtime branch of a search
+template <typename Visit>
+decltype(auto) withProfile(Difficulty difficulty, Visit&& visit) {
+    switch (difficulty) {
+    case Difficulty::Easy: return visit(EasyProfile{});
+    case Difficulty::Medium: return visit(MediumProfile{});
+    case Difficulty::Hard:
+    default: return visit(HardProfile{});
+    }
+}
 
-        while (!frontier.empty()) {
-            Position current = frontier.front();
-            frontier.pop();
+// 'terms' are the incremental evaluation terms of 'state' (SearchPosition::evaluation during a search)
+template <typename Profile>
+int evaluate(const GameState& state, const IncrementalEval& terms, Player perspective, Profile profile) {
+    if (state.isFinished()) {
+        return detail::evaluateTerminal(state, perspective);
+    }
 
-            auto neighbors = gatherReachableTiles(workingBoard, current);
-            for (const auto& neighbor : neighbors) {
-                auto idx = indexOf(neighbor.row, neighbor.col);
-                if (visited[idx]) {
-                    continue;
-                }
-                visited[idx] = true;
-                frontier.push(neighbor);
-                ++count;
-            }
-        }
+    Player opponent = detail::getOpponent(perspective);
+    
+    // HEURISTIC WEIGHTS (in sixteenths, per profile; tuned values are loaded at startup)
+    const EvalWeights::Terms& weights = EvalWeights::instance().of(profile);
+
+    // 1. MOBILITY (All Profiles)
+    int mobility = detail::mobilityCount(state, perspective) - detail::mobilityCount(state, opponent);
+    int score = mobility * weights.mobility;
 
-        return count;
+    // 2. SPATIAL INFLUENCE (Medium & Hard)
+    if constexpr (Profile::kSpatial) {
+        int spatial = detail::spatialInfluenceScore(terms, perspective);
+        score += spatial * weights.spatial;
     }
 
-    // NEW: Territory Score (Only used in Hard mode due to cost)
-    inline int territoryScore(const GameState& state, Player player) {
-        Player opponent = getOpponent(player);
-        std::size_t playerReachable = 0;
-        std::size_t opponentReachable = 0;
+    // 3. TERRITORY CONTROL (Hard Only)
+    // Four breadth-first passes per call, so we strictly limit it to Hard
+    if constexpr (Profile::kTerritory) {
+        int territory = detail::territoryScore(state, perspective);
+        score += territory * weights.territory;
+    }
+
+    return score / EvalWeights::kScale;
+}
+
+inline int evaluate(const GameState& state, const IncrementalEval& terms, Player perspective, Difficulty difficulty) {
+    return withProfile(difficulty, [&](auto profile) { return evaluate(state, terms, perspective, profile); });
+}
 
-        for (const auto& pos : scanForQueens(state, player)) {
-            playerReachable += floodFillReachableTiles(state, pos);
+template <typename Profile>
+int evaluate(const GameState& state, Player perspective, Profile profile) {
+    return evaluate(state, IncrementalEval(state.board()), perspective, profile);
+}
+
+inline int evaluate(const GameState& state, Player perspective, Difficulty difficulty) {
+    return evaluate(state, IncrementalEval(state.board()), perspective, difficulty);
+}
+
+// evaluate() of every position of 'positions' into 'scores', in SIMD blocks on up to 'threads' threads
+template <typename Profile>
+void evaluate(const batch::PositionBatch& positions, Player perspective, Profile profile, std::vector<int>& scores,
+    unsigned threads = 1) {
+    std::vector<batch::Terms> terms;
+    batch::evaluateTerms(positions, perspective, profile, terms, threads);
+    const EvalWeights::Terms& weights = EvalWeights::instance().of(profile);
+    scores.resize(positions.size());
+    for (std::size_t idx = 0; idx < positions.size(); ++idx) {
+        if (positions.finished(idx)) {
+            scores[idx] = detail::evaluateTerminal(positions.winner(idx), perspective);
+            continue;
+        }
+        int score = terms[idx].mobility * weights.mobility;
+        if constexpr (Profile::kSpatial) {
+            score += terms[idx].spatial * weights.spatial;
         }
+        if constexpr (Profile::kTerritory) {
+            score += terms[idx].territory * weights.territory;
+        }
+        scores[idx] = score / EvalWeights::kScale;
+    }
+}
 
-        for (const auto& pos : scanForQueens(state, opponent)) {
-            opponentReachable += floodFillReachableTiles(state, pos);
+inline int depthForDifficulty(Difficulty difficulty) {
+    switch (difficulty) {
+    case Difficulty::Easy: return 2;
+    case Difficulty::Medium: return 3;
+    case Difficulty::Hard:
+    default: return 4;
+    }
+}
+
+enum class SearchParallelism : std::uint8_t {
+    // Helper threads run the same iterative deepening on their own positions and share the
+    // transposition table; the move always comes from the main thread.
+    LazySmp = 0,
+    // Root moves of each iteration are handed out to the shared thread pool after the first
+    // one has set the bound; the best score so far is shared through an atomic.
+    RootSplit,
+    // Young Brothers Wait: once the eldest child of a node is searched, its younger brothers
+    // become a split point that idle workers steal from per-worker deques (any depth)
+    SplitPoints
+};
+
+enum class SearchEngine : std::uint8_t {
+    AlphaBeta = 0,  // iterative deepening minimax below
+    MonteCarlo      // UCT tree search with playouts (Mcts.h)
+};
+
+// Selectivity and time limits for one search. Every legal move is generated and ordered;
+// progressive widening decides how many of them a node looks at, late move reductions
+// decide how deeply the later ones are searched.
+struct SearchLimits {
+    int maxDepth = 3;
+    std::size_t baseWidth = 8;          // moves searched at a node one ply above the leaves
+    std::size_t widthPerPly = 4;        // extra moves let in for every additional ply of depth
+    std::size_t lmrFullDepthMoves = 3;  // leading moves that are never reduced
+    int lmrMinDepth = 2;                // no reductions below this remaining depth
+    std::chrono::milliseconds timeBudget{ 2000 };
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    // Half-move search: a turn is a queen ply followed by an arrow ply, each with its own
+    // ordering, widening, table entries and cutoffs. Width above applies to the queen ply.
+    bool halfMoveSearch = false;
+    std::size_t arrowBaseWidth = 4;
+    std::size_t arrowWidthPerPly = 2;
+
+    // Parallel search on 'threads' threads (1 = sequential), see SearchParallelism
+    unsigned threads = 1;
+    SearchParallelism parallelism = SearchParallelism::LazySmp;
+    int minSplitDepth = 2;  // SplitPoints: nodes with less depth left are searched sequentially
+    std::size_t tableMegabytes = 16;
+    std::size_t evalCacheMegabytes = 4;  // static evaluations cached across the search (0 = off)
+
+    // Alpha-beta leaves are scored by the evaluation network (nnue::Network) when one was loaded
+    // at startup, instead of the hand-written evaluate()
+    bool neuralEval = true;
+
+    // Monte Carlo tree search; uses timeBudget and threads from above
+    SearchEngine engine = SearchEngine::AlphaBeta;
+    std::size_t treeMegabytes = 64;
+    std::size_t treeChildren = 48;  // best ordered moves kept by an expanded node (the root keeps all)
+    std::uint32_t expandVisits = 8; // playouts through a leaf before it is expanded
+    int playoutTurns = 4;           // random turns before a playout is scored statically
+    double exploration = 0.5;       // UCT exploration constant
+
+    // Search the opponent's position while they think (SearchSession::ponder)
+    bool ponder = true;
+
+    // Opening book (OpeningBook::instance()) hits are played without searching; 'bookVariety'
+    // draws among the book candidates by weight instead of always taking the heaviest one
+    bool useBook = true;
+    bool bookVariety = false;
+
+    // Positions of the solved 6x6 proof tree (proof::perfectPlayBook()) are played from the database
+    bool perfectPlay = false;
+
+    // Settled endgames (no region holds queens of both colours) are played by the region solver
+    bool solveRegions = true;
+
+    // Endgame prover: once no more than 'proofSquares' empty squares are reachable by both sides,
+    // df-pn gets up to half the time budget to prove a win before the engine searches (0 = off)
+    int proofSquares = 0;
+    std::uint64_t proofNodes = 1000000;
+    std::size_t proofTableMegabytes = 32;
+};
+
+inline SearchLimits searchLimitsForDifficulty(Difficulty difficulty) {
+    SearchLimits limits;
+    limits.maxDepth = depthForDifficulty(difficulty);
+    switch (difficulty) {
+    case Difficulty::Easy:
+        limits.baseWidth = 6;
+        limits.widthPerPly = 4;
+        limits.timeBudget = std::chrono::milliseconds(500);
+        limits.useBook = false;
+        limits.ponder = false;
+        limits.neuralEval = false;
+        limits.solveRegions = false;
+        break;
+    case Difficulty::Medium:
+        limits.baseWidth = 8;
+        limits.widthPerPly = 6;
+        limits.timeBudget = std::chrono::milliseconds(1500);
+        limits.bookVariety = true;
+        limits.proofSquares = 16;
+        limits.proofNodes = 200000;
+        break;
+    case Difficulty::Hard:
+    default:
+        limits.baseWidth = 6;
+        limits.widthPerPly = 4;
+        limits.halfMoveSearch = true;
+        limits.arrowBaseWidth = 4;
+        limits.arrowWidthPerPly = 2;
+        limits.timeBudget = std::chrono::milliseconds(3000);
+        limits.threads = std::max(1u, std::thread::hardware_concurrency());
+        limits.tableMegabytes = 64;
+        limits.perfectPlay = true;
+        limits.proofSquares = 24;
+        break;
+    }
+    return limits;
+}
+
+// Everything a search shares across its nodes
+struct SearchContext {
+    SearchLimits limits;
+    TranspositionTable* table = nullptr;
+    EvalCache* evalCache = nullptr;
+    const std::atomic_bool* cancel = nullptr;  // user cancellation, surfaces as SearchCanceled
+    const std::atomic_bool* abort = nullptr;   // main thread is done, helpers stop quietly
+
+    // Split-point search: the scheduler, the worker running this search and the innermost
+    // split point it runs under (a cutoff there or above aborts the search with SplitCutoff)
+    WorkStealingScheduler* scheduler = nullptr;
+    unsigned worker = 0;
+    const SplitPoint* splitPoint = nullptr;
+};
+
+namespace detail {
+
+    // Progressive widening: nodes with more depth left below them get to look at more moves.
+    inline std::size_t progressiveWidth(const SearchLimits& limits, int depth) {
+        return limits.baseWidth + limits.widthPerPly * static_cast<std::size_t>(std::max(0, depth - 1));
+    }
+
+    inline std::size_t arrowWidth(const SearchLimits& limits, int depth) {
+        return limits.arrowBaseWidth + limits.arrowWidthPerPly * static_cast<std::size_t>(std::max(0, depth - 1));
+    }
+
+    // Late move reduction by ordering rank; very late moves are reduced one ply further.
+    inline int lateMoveReduction(const SearchLimits& limits, int depth, std::size_t rank) {
+        if (depth < limits.lmrMinDepth || rank < limits.lmrFullDepthMoves) {
+            return 0;
         }
+        int reduction = rank >= 3 * limits.lmrFullDepthMoves ? 2 : 1;
+        return std::min(reduction, depth - 1);
+    }
 
-        return static_cast<int>(playerReachable) - static_cast<int>(opponentReachable);
+    inline void checkSearchLimits(const SearchContext& context) {
+        if (context.cancel && context.cancel->load()) throw SearchCanceled();
+        if (context.abort && context.abort->load(std::memory_order_relaxed)) throw SearchTimedOut();
+        if (context.splitPoint && context.splitPoint->cutoff()) throw SplitCutoff();
+        if (std::chrono::steady_clock::now() >= context.limits.deadline) throw SearchTimedOut();
     }
 
-    // NEW: Spatial Influence (Used in Medium/Hard)
-    inline int spatialInfluenceScore(const GameState& state, Player player) {
+    // How much an arrow or queen on each square hurts the opponent of 'player': squares their
+    // queens can reach, weighted up for squares right next to a queen.
+    inline std::vector<int> opponentPressure(const GameState& state, Player player) {
         const auto& board = state.board();
         int dim = board.dimension();
+        std::vector<int> pressure(static_cast<std::size_t>(dim * dim), 0);
+        for (const auto& opponentQueen : state.queenPositions(getOpponent(player))) {
+            for (const auto& tile : gatherReachableTiles(board, opponentQueen)) {
+                bool adjacent = std::abs(tile.row - opponentQueen.row) <= 1 && std::abs(tile.col - opponentQueen.col) <= 1;
+                pressure[static_cast<std::size_t>(tile.row * dim + tile.col)] += adjacent ? 7 : 4;
+            }
+        }
+        return pressure;
+    }
 
-        if (dim == 0) return 0;
+    // Keeps the best 'width' entries, best first
+    template <typename Entry>
+    void keepBest(std::vector<Entry>& entries, std::size_t width) {
+        auto byScore = [](const Entry& a, const Entry& b) { return a.score > b.score; };
+        if (entries.size() > width) {
+            std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(width), entries.end(), byScore);
+            entries.resize(width);
+        }
+        else {
+            std::sort(entries.begin(), entries.end(), byScore);
+        }
+    }
 
-        double center = (dim - 1) / 2.0;
+    inline constexpr int kHintBonus = 1 << 20;
 
-        auto positionalValue = [&](const Position& pos) {
-            // Distance from center
-            double dist = std::abs(pos.row - center) + std::abs(pos.col - center);
-            double maxDist = 2.0 * (dim - 1);
-            // Normalized: 1.0 = Center, 0.0 = Corner
-            double normalized = 1.0 - (dist / maxDist);
-            
-            // Factor in mobility slightly to ensure the spot isn't a trap
-            auto mobility = gatherReachableTiles(board, pos).size();
-            return static_cast<double>(mobility) * 0.25 + normalized * 10.0;
-        };
+    inline bool matchesSquare(const SearchPosition& position, const Position& pos, std::uint8_t square) {
+        return square != TableMove::kNone && position.squareIndex(pos) == square;
+    }
 
-        double score = 0.0;
-        for (const auto& pos : scanForQueens(state, player)) {
-            score += positionalValue(pos);
+    struct OrderedMove {
+        Move move;
+        int score;
+    };
+
+    // Generates every legal move with a cheap ordering score and keeps the best 'width' of them.
+    // Score = mobility of the queen on its destination + opponent pressure of the arrow square.
+    inline std::vector<OrderedMove> generateOrderedMoves(const SearchPosition& position, std::size_t width, const TableMove& hint) {
+        std::vector<OrderedMove> ordered;
+        Player player = position.currentPlayer();
+        if (player == Player::None || width == 0) {
+            return ordered;
         }
 
-        for (const auto& pos : scanForQueens(state, getOpponent(player))) {
-            score -= positionalValue(pos);
+        const auto& state = position.state();
+        const auto& board = state.board();
+        auto pressure = opponentPressure(state, player);
+
+        Board simulatedBoard = board;
+        TileContent queenTile = tileForPlayer(player);
+        for (const auto& queenPos : state.queenPositions(player)) {
+            for (const auto& queenDest : gatherReachableTiles(board, queenPos)) {
+                simulatedBoard.setTile(queenPos.row, queenPos.col, TileContent::Empty);
+                simulatedBoard.setTile(queenDest.row, queenDest.col, queenTile);
+
+                auto arrowTargets = gatherReachableTiles(simulatedBoard, queenDest);
+                int destinationScore = 2 * static_cast<int>(arrowTargets.size());
+                bool hintedStep = matchesSquare(position, queenPos, hint.from) && matchesSquare(position, queenDest, hint.to);
+                for (const auto& arrowDest : arrowTargets) {
+                    int score = destinationScore + pressure[static_cast<std::size_t>(position.squareIndex(arrowDest))];
+                    if (hintedStep && matchesSquare(position, arrowDest, hint.arrow)) {
+                        score += kHintBonus;
+                    }
+                    ordered.push_back({ { player, queenPos, queenDest, arrowDest }, score });
+                }
+
+                simulatedBoard.setTile(queenDest.row, queenDest.col, TileContent::Empty);
+                simulatedBoard.setTile(queenPos.row, queenPos.col, queenTile);
+            }
         }
 
-        return static_cast<int>(score);
+        keepBest(ordered, width);
+        return ordered;
     }
 
-    inline int evaluateTerminal(const GameState& state, Player perspective) {
-        if (!state.isFinished()) return 0;
+    struct QueenStep {
+        Position from;
+        Position to;
+        int score;
+    };
 
-        if (state.winner() == perspective) {
-            return std::numeric_limits<int>::max() / 4;
-        }
-        if (state.winner() == getOpponent(perspective)) {
-            return std::numeric_limits<int>::min() / 4;
+    // Queen ply of the half-move search. Destinations are scored by the queen's mobility there and
+    // the pressure the square puts on the opponent; no arrows are generated at this point.
+    inline std::vector<QueenStep> generateQueenSteps(const SearchPosition& position, std::size_t width, const TableMove& hint) {
+        std::vector<QueenStep> steps;
+        Player player = position.currentPlayer();
+        const auto& state = position.state();
+        const auto& board = state.board();
+        auto pressure = opponentPressure(state, player);
+
+        Board simulatedBoard = board;
+        TileContent queenTile = tileForPlayer(player);
+        for (const auto& queenPos : state.queenPositions(player)) {
+            simulatedBoard.setTile(queenPos.row, queenPos.col, TileContent::Empty);
+            for (const auto& queenDest : gatherReachableTiles(board, queenPos)) {
+                simulatedBoard.setTile(queenDest.row, queenDest.col, queenTile);
+                int mobility = static_cast<int>(gatherReachableTiles(simulatedBoard, queenDest).size());
+                int score = 2 * mobility + pressure[static_cast<std::size_t>(position.squareIndex(queenDest))];
+                if (matchesSquare(position, queenPos, hint.from) && matchesSquare(position, queenDest, hint.to)) {
+                    score += kHintBonus;
+                }
+                steps.push_back({ queenPos, queenDest, score });
+                simulatedBoard.setTile(queenDest.row, queenDest.col, TileContent::Empty);
+            }
+            simulatedBoard.setTile(queenPos.row, queenPos.col, queenTile);
         }
-        return 0;
+
+        keepBest(steps, width);
+        return steps;
     }
 
-    inline bool isTerminal(const GameState& state) {
-        if (state.isFinished()) return true;
-        return !hasAnyLegalMove(state, state.currentPlayer());
+    struct ArrowShot {
+        Position arrow;
+        int score;
+    };
+
+    // Arrow ply of the half-move search, run on the position after the queen step
+    inline std::vector<ArrowShot> generateArrowShots(const SearchPosition& position, std::size_t width, const TableMove& hint) {
+        std::vector<ArrowShot> shots;
+        const auto& state = position.state();
+        auto pressure = opponentPressure(state, position.currentPlayer());
+        for (const auto& arrow : gatherReachableTiles(state.board(), position.pendingShooter())) {
+            int score = pressure[static_cast<std::size_t>(position.squareIndex(arrow))];
+            if (matchesSquare(position, arrow, hint.arrow)) {
+                score += kHintBonus;
+            }
+            shots.push_back({ arrow, score });
+        }
+
+        keepBest(shots, width);
+        return shots;
     }
-}
 
-// UPDATED: Accepts 'difficulty' to toggle heuristics
-inline int evaluate(const GameState& state, Player perspective, Difficulty difficulty) {
-    if (state.isFinished()) {
-        return detail::evaluateTerminal(state, perspective);
+    inline int terminalScore(Player loser, Player perspective) {
+        return loser == perspective ? std::numeric_limits<int>::min() / 4 : std::numeric_limits<int>::max() / 4;
     }
 
-    Player opponent = detail::getOpponent(perspective);
-    
-    // HEURISTIC WEIGHTS
-    const int mobilityWeight = 3;
-    const int spatialWeight = 1; 
-    const int territoryWeight = 5; 
+    // Evaluation cache key: the position's hash salted with what else the score depends on, so
+    // profiles and perspectives don't share entries. Every hand-written term is symmetric, so
+    // those use the canonical hash; the network need not be.
+    template <typename Profile>
+    std::uint64_t evalCacheKey(const SearchPosition& position, Player perspective, bool neural) {
+        int sym = 0;
+        std::uint64_t hash = neural ? position.hash() : position.canonicalHash(sym);
+        std::uint64_t profile = neural ? 0 : Profile::kId + 1;
+        std::uint64_t salt = 2 * profile + (perspective == Player::White ? 1 : 2);
+        return hash ^ (salt * 0x9E3779B97F4A7C15ull);
+    }
 
-    // 1. MOBILITY (All Difficulties)
-    int mobility = detail::mobilityCount(state, perspective) - detail::mobilityCount(state, opponent);
-    int score = mobility * mobilityWeight;
+    // Static value of a position between full turns; a side without a legal move has lost.
+    // 'neural' picks the evaluation network for positions that track its accumulator.
+    template <typename Profile>
+    int evaluateLeaf(const SearchPosition& position, Player perspective, Profile profile,
+        EvalCache* cache = nullptr, bool neural = false) {
+        const nnue::Accumulator* accumulator = neural ? position.accumulator() : nullptr;
+        std::uint64_t key = 0;
+        int score = 0;
+        if (cache) {
+            key = evalCacheKey<Profile>(position, perspective, accumulator != nullptr);
+            if (cache->probe(key, score)) {
+                return score;
+            }
+        }
 
-    // Easy: Mobility Only (Fastest)
-    if (difficulty == Difficulty::Easy) {
+        Player toMove = position.currentPlayer();
+        if (!hasAnyLegalMove(position.state(), toMove)) {
+            score = terminalScore(toMove, perspective);
+        }
+        else if (accumulator) {
+            score = nnue::Network::instance().evaluate(*accumulator, toMove);
+            score = toMove == perspective ? score : -score;
+        }
+        else if (const IncrementalEval* terms = position.evaluation()) {
+            score = evaluate(position.state(), *terms, perspective, profile);
+        }
+        else {
+            score = evaluate(position.state(), perspective, profile);
+        }
+        if (cache) {
+            cache->store(key, score);
+        }
         return score;
     }
 
-    // 2. SPATIAL INFLUENCE (Medium & Hard)
-    int spatial = detail::spatialInfluenceScore(state, perspective);
-    score += spatial * spatialWeight;
+    // Table scores are kept from White's point of view so entries stay valid for either side
+    inline int toTableScore(int score, Player perspective) {
+        return perspective == Player::White ? score : -score;
+    }
 
-    // 3. TERRITORY CONTROL (Hard Only)
-    // Flood fill is expensive, so we strictly limit it to Hard
-    if (difficulty == Difficulty::Hard) {
-        int territory = detail::territoryScore(state, perspective);
-        score += territory * territoryWeight;
+    inline int fromTableScore(int score, Player perspective) {
+        return perspective == Player::White ? score : -score;
     }
 
-    return score;
-}
+    // Table slot of a position: its canonical hash, so mirror and rotation images share an entry.
+    // Move hints are stored in the canonical orientation and mapped back with 'symmetry'. The
+    // network isn't symmetric (Black's view only flips rows), so positions it scores ('neural' and
+    // an accumulator) use the plain hash and symmetry 0, as in evalCacheKey.
+    struct TableKey {
+        std::uint64_t hash = 0;
+        int dimension = 0;
+        int symmetry = 0;
+    };
 
-// UPDATED: Propagates 'difficulty' to evaluate
-inline int minimax(GameState& state, int depth, int alpha, int beta, Player maximizingPlayer,
-    Player perspective, std::size_t moveCap, Difficulty difficulty, const std::atomic_bool* cancel = nullptr) {
-    
-    if (cancel && cancel->load()) throw SearchCanceled();
+    inline TableKey tableKey(const SearchPosition& position, bool neural) {
+        TableKey key;
+        key.hash = neural && position.accumulator() ? position.hash() : position.canonicalHash(key.symmetry);
+        key.dimension = position.dimension();
+        return key;
+    }
 
-    bool terminal = depth == 0 || detail::isTerminal(state);
-    if (terminal) {
-        GameState evalState = state;
-        evaluateWinState(evalState);
-        return detail::evaluateTerminal(evalState, perspective);
+    inline std::uint8_t mapHintSquare(std::uint8_t square, const TableKey& key, bool toCanonical) {
+        if (square == TableMove::kNone) {
+            return square;
+        }
+        return static_cast<std::uint8_t>(toCanonical ? symmetry::apply(key.symmetry, key.dimension, square)
+                                                     : symmetry::undo(key.symmetry, key.dimension, square));
     }
 
-    Player current = state.currentPlayer();
-    bool isMaximizing = current == maximizingPlayer;
-    auto moves = generateMovesForPlayer(state, current, moveCap);
+    inline TableMove mapHint(const TableMove& move, const TableKey& key, bool toCanonical) {
+        return { mapHintSquare(move.from, key, toCanonical), mapHintSquare(move.to, key, toCanonical),
+            mapHintSquare(move.arrow, key, toCanonical) };
+    }
 
-    if (moves.empty()) {
-        GameState evalState = state;
-        evaluateWinState(evalState);
-        return detail::evaluateTerminal(evalState, perspective);
+    // Returns true when the stored entry settles the node; otherwise narrows the window
+    inline bool probeTable(const SearchContext& context, const TableKey& key, int depth, Player perspective,
+        int& alpha, int& beta, int& value, TableMove& hint) {
+        TableEntry entry;
+        if (!context.table || !context.table->probe(key.hash, entry)) {
+            return false;
+        }
+        hint = mapHint(entry.move, key, false);
+        if (entry.depth < depth) {
+            return false;
+        }
+        int score = fromTableScore(entry.score, perspective);
+        Bound bound = entry.bound;
+        if (perspective != Player::White && bound != Bound::Exact) {
+            bound = bound == Bound::Lower ? Bound::Upper : Bound::Lower;
+        }
+        if (bound == Bound::Exact) {
+            value = score;
+            return true;
+        }
+        if (bound == Bound::Lower) {
+            alpha = std::max(alpha, score);
+        }
+        else if (bound == Bound::Upper) {
+            beta = std::min(beta, score);
+        }
+        if (alpha >= beta) {
+            value = score;
+            return true;
+        }
+        return false;
     }
 
-    if (isMaximizing) {
-        int value = std::numeric_limits<int>::min();
-        for (const auto& move : moves) {
-            if (cancel && cancel->load()) throw SearchCanceled();
-            GameState next = state.clone();
-            applyMove(next, move);
-            int child = minimax(next, depth - 1, alpha, beta, maximizingPlayer, perspective, moveCap, difficulty, cancel);
+    inline void storeTable(SearchContext& context, const TableKey& key, int depth, Player perspective,
+        int value, int alphaOrig, int betaOrig, const TableMove& best) {
+        if (!context.table) {
+            return;
+        }
+        Bound bound = Bound::Exact;
+        if (value <= alphaOrig) {
+            bound = Bound::Upper;
+        }
+        else if (value >= betaOrig) {
+            bound = Bound::Lower;
+        }
+        if (perspective != Player::White && bound != Bound::Exact) {
+            bound = bound == Bound::Lower ? Bound::Upper : Bound::Lower;
+        }
+        context.table->store(key.hash, depth, toTableScore(value, perspective), bound, mapHint(best, key, true));
+    }
+
+    // Folds a child value into a max or min node; returns true on a cutoff
+    inline bool updateWindow(bool isMaximizing, int child, int& value, int& alpha, int& beta) {
+        if (isMaximizing) {
             value = std::max(value, child);
             alpha = std::max(alpha, value);
-            if (alpha >= beta) break;
         }
-        return value;
+        else {
+            value = std::min(value, child);
+            beta = std::min(beta, value);
+        }
+        return alpha >= beta;
     }
 
-    int value = std::numeric_limits<int>::max();
-    for (const auto& move : moves) {
-        if (cancel && cancel->load()) throw SearchCanceled();
-        GameState next = state.clone();
-        applyMove(next, move);
-        int child = minimax(next, depth - 1, alpha, beta, maximizingPlayer, perspective, moveCap, difficulty, cancel);
-        value = std::min(value, child);
-        beta = std::min(beta, value);
-        if (alpha >= beta) break;
+    // True when a reduced child result is good enough for its node to need a full-depth re-search
+    inline bool needsReSearch(bool isMaximizing, int child, int alpha, int beta) {
+        return isMaximizing ? child > alpha : child < beta;
     }
-    return value;
 }
 
-inline int depthForDifficulty(Difficulty difficulty) {
-    switch (difficulty) {
-    case Difficulty::Easy: return 2;
-    case Difficulty::Medium: return 3;
-    case Difficulty::Hard:
-    default: return 3;
+template <typename Profile>
+int minimax(SearchPosition& position, int depth, int alpha, int beta, Player maximizingPlayer,
+    Player perspective, SearchContext& context, Profile profile);
+
+namespace detail {
+
+    inline bool canSplit(const SearchContext& context, int depth, std::size_t siblings) {
+        return context.scheduler && depth >= context.limits.minSplitDepth && siblings > 1;
+    }
+
+    // Younger brothers [first, count) as a split point. Each job copies the node position, reads
+    // the current window, searches its child and folds the result back in under the window lock;
+    // a cutoff stops the remaining siblings. A cutoff further up aborts this node as well.
+    template <typename SearchChild, typename ChildBest, typename Best>
+    void searchSiblingsParallel(const SearchPosition& position, std::size_t first, std::size_t count, bool isMaximizing,
+        int& value, int& alpha, int& beta, Best& best, SearchContext& context,
+        const SearchChild& searchChild, const ChildBest& childBest) {
+        std::mutex windowMutex;
+        SplitPoint split(context.splitPoint, first, count, [&](std::size_t idx, unsigned worker) {
+            int jobAlpha = 0;
+            int jobBeta = 0;
+            {
+                std::lock_guard<std::mutex> lock(windowMutex);
+                jobAlpha = alpha;
+                jobBeta = beta;
+            }
+            SearchContext jobContext = context;
+            jobContext.worker = worker;
+            jobContext.splitPoint = &split;
+            SearchPosition local = position;
+            int child = searchChild(local, idx, jobAlpha, jobBeta, jobContext);
+
+            std::lock_guard<std::mutex> lock(windowMutex);
+            int previous = value;
+            if (updateWindow(isMaximizing, child, value, alpha, beta)) {
+                split.signalCutoff();
+            }
+            if (value != previous) {
+                best = childBest(idx);
+            }
+        });
+        context.scheduler->runSplit(context.worker, split);
+
+        if (context.splitPoint && context.splitPoint->cutoff()) {
+            throw SplitCutoff();
+        }
+    }
+
+    // Child loop shared by every node type. 'searchChild' makes, searches and unmakes child 'idx'
+    // on the position it is given; 'childBest' is what to remember when that child becomes best.
+    // The eldest child is always searched here first; with a scheduler the rest may be split off.
+    template <typename SearchChild, typename ChildBest, typename Best>
+    void searchChildren(SearchPosition& position, std::size_t count, int depth, bool isMaximizing,
+        int& value, int& alpha, int& beta, Best& best, SearchContext& context,
+        const SearchChild& searchChild, const ChildBest& childBest) {
+        for (std::size_t idx = 0; idx < count; ++idx) {
+            if (idx == 1 && canSplit(context, depth, count - 1)) {
+                searchSiblingsParallel(position, 1, count, isMaximizing, value, alpha, beta, best, context, searchChild, childBest);
+                return;
+            }
+            int child = searchChild(position, idx, alpha, beta, context);
+            int previous = value;
+            bool cutoff = updateWindow(isMaximizing, child, value, alpha, beta);
+            if (value != previous) {
+                best = childBest(idx);
+            }
+            if (cutoff) {
+                return;
+            }
+        }
     }
 }
 
-inline std::size_t moveCapForDifficulty(Difficulty difficulty) {
-    switch (difficulty) {
-    case Difficulty::Easy: return 100;
-    case Difficulty::Medium: return 120;
-    case Difficulty::Hard:
-    default: return 150;
+namespace detail {
+
+    // Arrow ply of a half-move turn: the queen has stepped, the same side picks where to shoot.
+    // Depth is counted in full turns, so the arrow ply hands 'depth - 1' to the next queen ply.
+    template <typename Profile>
+    int searchArrowPly(SearchPosition& position, int depth, int alpha, int beta, Player maximizingPlayer,
+        Player perspective, SearchContext& context, Profile profile) {
+
+        checkSearchLimits(context);
+
+        int alphaOrig = alpha;
+        int betaOrig = beta;
+        int value = 0;
+        TableMove hint;
+        TableKey key = tableKey(position, context.limits.neuralEval);
+        if (probeTable(context, key, depth, perspective, alpha, beta, value, hint)) {
+            return value;
+        }
+
+        bool isMaximizing = position.currentPlayer() == maximizingPlayer;
+        Position shooter = position.pendingShooter();
+        auto shots = generateArrowShots(position, arrowWidth(context.limits, depth), hint);
+
+        auto searchChild = [&](SearchPosition& node, std::size_t idx, int childAlpha, int childBeta, SearchContext& childContext) {
+            const auto& arrow = shots[idx].arrow;
+            node.makeArrow(arrow);
+            int reduction = lateMoveReduction(childContext.limits, depth, idx);
+            int child = minimax(node, depth - 1 - reduction, childAlpha, childBeta, maximizingPlayer, perspective, childContext, profile);
+            if (reduction > 0 && needsReSearch(isMaximizing, child, childAlpha, childBeta)) {
+                child = minimax(node, depth - 1, childAlpha, childBeta, maximizingPlayer, perspective, childContext, profile);
+            }
+            node.unmakeArrow(shooter, arrow);
+            return child;
+        };
+        auto childBest = [&](std::size_t idx) {
+            TableMove move;
+            move.arrow = static_cast<std::uint8_t>(position.squareIndex(shots[idx].arrow));
+            return move;
+        };
+
+        value = isMaximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+        TableMove best;
+        searchChildren(position, shots.size(), depth, isMaximizing, value, alpha, beta, best, context, searchChild, childBest);
+
+        storeTable(context, key, depth, perspective, value, alphaOrig, betaOrig, best);
+        return value;
+    }
+
+    // Queen ply of a half-move turn. Only the best-ordered destinations are expanded, so the
+    // arrows of poor queen steps are never generated at all.
+    template <typename Profile>
+    int searchQueenPly(SearchPosition& position, int depth, int alpha, int beta, Player maximizingPlayer,
+        Player perspective, SearchContext& context, Profile profile, const TableKey& key, const TableMove& hint) {
+
+        bool isMaximizing = position.currentPlayer() == maximizingPlayer;
+        auto steps = generateQueenSteps(position, progressiveWidth(context.limits, depth), hint);
+        if (steps.empty()) {
+            return terminalScore(position.currentPlayer(), perspective);
+        }
+
+        int alphaOrig = alpha;
+        int betaOrig = beta;
+        int value = isMaximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+        auto searchChild = [&](SearchPosition& node, std::size_t idx, int childAlpha, int childBeta, SearchContext& childContext) {
+            const auto& step = steps[idx];
+            node.makeQueenStep(step.from, step.to);
+            int child = searchArrowPly(node, depth, childAlpha, childBeta, maximizingPlayer, perspective, childContext, profile);
+            node.unmakeQueenStep(step.from, step.to);
+            return child;
+        };
+        auto childBest = [&](std::size_t idx) {
+            TableMove move;
+            move.from = static_cast<std::uint8_t>(position.squareIndex(steps[idx].from));
+            move.to = static_cast<std::uint8_t>(position.squareIndex(steps[idx].to));
+            return move;
+        };
+
+        TableMove best;
+        searchChildren(position, steps.size(), depth, isMaximizing, value, alpha, beta, best, context, searchChild, childBest);
+
+        storeTable(context, key, depth, perspective, value, alphaOrig, betaOrig, best);
+        return value;
     }
 }
 
-inline Move getBestMove(const GameState& state, Difficulty difficulty, const std::atomic_bool* cancel = nullptr) {
-    GameState rootState = state;
-    std::size_t moveCap = moveCapForDifficulty(difficulty);
-    auto moves = generateMovesForPlayer(rootState, rootState.currentPlayer(), moveCap);
+// Alpha-beta over a SearchPosition between full turns, scores from 'perspective'.
+// Depth is counted in full turns in both move models.
+template <typename Profile>
+int minimax(SearchPosition& position, int depth, int alpha, int beta, Player maximizingPlayer,
+    Player perspective, SearchContext& context, Profile profile) {
+    
+    detail::checkSearchLimits(context);
+
+    if (depth <= 0) {
+        return detail::evaluateLeaf(position, perspective, profile, context.evalCache, context.limits.neuralEval);
+    }
+
+    int value = 0;
+    TableMove hint;
+    detail::TableKey key = detail::tableKey(position, context.limits.neuralEval);
+    if (detail::probeTable(context, key, depth, perspective, alpha, beta, value, hint)) {
+        return value;
+    }
+
+    if (context.limits.halfMoveSearch) {
+        return detail::searchQueenPly(position, depth, alpha, beta, maximizingPlayer, perspective, context, profile, key, hint);
+    }
 
+    Player current = position.currentPlayer();
+    bool isMaximizing = current == maximizingPlayer;
+    auto moves = detail::generateOrderedMoves(position, detail::progressiveWidth(context.limits, depth), hint);
     if (moves.empty()) {
-        return {};
+        return detail::terminalScore(current, perspective);
     }
 
-    int searchDepth = std::max(1, depthForDifficulty(difficulty));
-    Player maximizingPlayer = rootState.currentPlayer();
-    Player perspective = maximizingPlayer;
+    int alphaOrig = alpha;
+    int betaOrig = beta;
+    value = isMaximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+    auto searchChild = [&](SearchPosition& node, std::size_t idx, int childAlpha, int childBeta, SearchContext& childContext) {
+        const auto& move = moves[idx].move;
+        node.makeMove(move);
+
+        // Reduced search first; re-search at full depth only if the move looks like it matters
+        int reduction = detail::lateMoveReduction(childContext.limits, depth, idx);
+        int child = minimax(node, depth - 1 - reduction, childAlpha, childBeta, maximizingPlayer, perspective, childContext, profile);
+        if (reduction > 0 && detail::needsReSearch(isMaximizing, child, childAlpha, childBeta)) {
+            child = minimax(node, depth - 1, childAlpha, childBeta, maximizingPlayer, perspective, childContext, profile);
+        }
+        node.unmakeMove(move);
+        return child;
+    };
+    auto childBest = [&](std::size_t idx) {
+        const auto& move = moves[idx].move;
+        return TableMove{ static_cast<std::uint8_t>(position.squareIndex(move.queenFrom)),
+            static_cast<std::uint8_t>(position.squareIndex(move.queenTo)),
+            static_cast<std::uint8_t>(position.squareIndex(move.arrow)) };
+    };
+
+    TableMove best;
+    detail::searchChildren(position, moves.size(), depth, isMaximizing, value, alpha, beta, best, context, searchChild, childBest);
+
+    detail::storeTable(context, key, depth, perspective, value, alphaOrig, betaOrig, best);
+    return value;
+}
+
+namespace detail {
 
     struct ScoredMove {
         Move move;
         int heuristic;
     };
 
-    std::vector<ScoredMove> scored;
-    scored.reserve(moves.size());
+    // Every legal root move with a full static evaluation, best first
+    template <typename Profile>
+    std::vector<ScoredMove> orderRootMoves(const GameState& rootState, Player perspective, Profile profile,
+        const std::atomic_bool* cancel, EvalCache* cache = nullptr, bool neural = false) {
+        auto moves = generateMovesForPlayer(rootState, rootState.currentPlayer());
+        std::vector<ScoredMove> scored;
+        scored.reserve(moves.size());
 
-    // Move Ordering
-    for (const auto& move : moves) {
-        GameState next = rootState.clone();
-        applyMove(next, move);
-        // Use the difficulty-specific evaluation
-        int heuristic = evaluate(next, perspective, difficulty);
-        scored.push_back({ move, heuristic });
+        SearchPosition position(rootState);
+        if (neural && position.accumulator()) {
+            for (const auto& move : moves) {
+                if (cancel && cancel->load()) throw SearchCanceled();
+                position.makeMove(move);
+                int heuristic = evaluateLeaf(position, perspective, profile, cache, neural);
+                position.unmakeMove(move);
+                scored.push_back({ move, heuristic });
+            }
+        }
+        else {
+            // Children the cache doesn't know and that aren't lost are evaluated in one batch
+            batch::PositionBatch children;
+            std::vector<std::size_t> pending;
+            std::vector<std::uint64_t> keys;
+            for (const auto& move : moves) {
+                if (cancel && cancel->load()) throw SearchCanceled();
+                position.makeMove(move);
+                int heuristic = 0;
+                std::uint64_t key = cache ? evalCacheKey<Profile>(position, perspective, false) : 0;
+                if (!cache || !cache->probe(key, heuristic)) {
+                    if (!hasAnyLegalMove(position.state(), position.currentPlayer())) {
+                        heuristic = terminalScore(position.currentPlayer(), perspective);
+                        if (cache) {
+                            cache->store(key, heuristic);
+                        }
+                    }
+                    else {
+                        children.add(position.state());
+                        pending.push_back(scored.size());
+                        keys.push_back(key);
+                    }
+                }
+                position.unmakeMove(move);
+                scored.push_back({ move, heuristic });
+            }
+
+            std::vector<int> scores;
+            evaluate(children, perspective, profile, scores);
+            for (std::size_t idx = 0; idx < pending.size(); ++idx) {
+                scored[pending[idx]].heuristic = scores[idx];
+                if (cache) {
+                    cache->store(keys[idx], scores[idx]);
+                }
+            }
+        }
+
+        std::stable_sort(scored.begin(), scored.end(), [](const ScoredMove& a, const ScoredMove& b) {
+            return a.heuristic > b.heuristic;
+        });
+        return scored;
     }
 
-    std::sort(scored.begin(), scored.end(), [](const ScoredMove& a, const ScoredMove& b) {
-        return a.heuristic > b.heuristic;
-    });
+    // Searches one root move with late move reduction (and re-search) by its rank
+    template <typename Profile>
+    int searchRootMove(SearchPosition& position, const Move& move, std::size_t rank, int depth, int alpha,
+        SearchContext& context, Profile profile) {
+        Player maximizingPlayer = position.currentPlayer();
+        Player perspective = maximizingPlayer;
+        position.makeMove(move);
 
-    Move bestMove = scored.front().move;
-    int bestScore = std::numeric_limits<int>::min();
+        int reduction = lateMoveReduction(context.limits, depth, rank);
+        int score = minimax(position, depth - 1 - reduction, alpha, std::numeric_limits<int>::max(),
+            maximizingPlayer, perspective, context, profile);
+        if (reduction > 0 && score > alpha) {
+            score = minimax(position, depth - 1, alpha, std::numeric_limits<int>::max(),
+                maximizingPlayer, perspective, context, profile);
+        }
 
-    int primaryDepth = std::max(0, searchDepth - 1);
-    int shallowDepth = std::max(0, primaryDepth - 1);
-    
-    // Variable Depth Logic for Hard: Only search the top 6 moves deeply
-    std::size_t deepSlots = (difficulty == Difficulty::Hard && scored.size() > 6) ? 6 : scored.size();
+        position.unmakeMove(move);
+        return score;
+    }
 
-    for (std::size_t idx = 0; idx < scored.size(); ++idx) {
-        const auto& entry = scored[idx];
-        GameState next = rootState.clone();
-        applyMove(next, entry.move);
+    struct RootIteration {
+        std::size_t bestIdx = 0;
+        int score = std::numeric_limits<int>::min();  // of the best move, exact unless timed out
+        bool timedOut = false;
+    };
 
-        int depthForMove = primaryDepth;
-        if (difficulty == Difficulty::Hard && idx >= deepSlots) {
-            depthForMove = shallowDepth;
+    // The first 'width' moves of 'scored', reduced by their index there or by 'ranks' if given
+    template <typename Profile>
+    RootIteration searchRootMoves(const GameState& rootState, const std::vector<ScoredMove>& scored,
+        std::size_t width, int depth, SearchContext& context, Profile profile, const std::vector<std::size_t>* ranks = nullptr) {
+        RootIteration iteration;
+        int value = std::numeric_limits<int>::min();
+        int alpha = std::numeric_limits<int>::min();
+        int beta = std::numeric_limits<int>::max();
+        SearchPosition position(rootState);
+
+        // With a split-point scheduler the root is a Young Brothers Wait node like any other
+        auto searchChild = [&](SearchPosition& node, std::size_t idx, int childAlpha, int, SearchContext& childContext) {
+            return searchRootMove(node, scored[idx].move, ranks ? (*ranks)[idx] : idx, depth, childAlpha, childContext, profile);
+        };
+        auto childBest = [](std::size_t idx) { return idx; };
+        try {
+            searchChildren(position, width, depth, true, value, alpha, beta, iteration.bestIdx, context, searchChild, childBest);
+        }
+        catch (const SearchTimedOut&) {
+            iteration.timedOut = true;
         }
+        iteration.score = value;
+        return iteration;
+    }
 
-        int score = minimax(next, depthForMove, std::numeric_limits<int>::min(),
-            std::numeric_limits<int>::max(), maximizingPlayer, perspective, moveCap, difficulty, cancel);
+    // Root split: the first (best-ordered) move is searched alone to set the bound, the rest go to
+    // the thread pool. Every task starts from the best score found so far, so later moves get a
+    // tighter window. A timeout in any task stops its siblings through the iteration abort flag.
+    template <typename Profile>
+    RootIteration searchRootParallel(const GameState& rootState, const std::vector<ScoredMove>& scored,
+        std::size_t width, int depth, SearchContext& context, Profile profile) {
+        RootIteration iteration;
+        SearchPosition position(rootState);
+        int firstScore = 0;
+        try {
+            firstScore = searchRootMove(position, scored.front().move, 0, depth, std::numeric_limits<int>::min(), context, profile);
+        }
+        catch (const SearchTimedOut&) {
+            iteration.timedOut = true;
+            return iteration;
+        }
 
-        if (score > bestScore) {
-            bestScore = score;
-            bestMove = entry.move;
+        auto& pool = ThreadPool::shared();
+        std::atomic<int> sharedAlpha{ firstScore };
+        std::atomic_bool iterationAborted{ false };
+        std::mutex bestMutex;
+        int bestScore = firstScore;
+
+        SearchContext taskContext = context;
+        taskContext.abort = &iterationAborted;
+        std::vector<SearchPosition> positions(pool.workerCount() + 1, position);
+
+        pool.run(width - 1, [&](std::size_t task, unsigned worker) {
+            if (iterationAborted.load()) {
+                return;
+            }
+            std::size_t idx = task + 1;
+            try {
+                int score = searchRootMove(positions[worker], scored[idx].move, idx, depth, sharedAlpha.load(), taskContext, profile);
+                std::lock_guard<std::mutex> lock(bestMutex);
+                if (score > bestScore) {
+                    bestScore = score;
+                    iteration.bestIdx = idx;
+                    sharedAlpha.store(score);
+                }
+            }
+            catch (const SearchTimedOut&) {
+                iterationAborted.store(true);
+                positions[worker] = SearchPosition(rootState);
+            }
+            catch (...) {
+                iterationAborted.store(true);
+                positions[worker] = SearchPosition(rootState);
+                throw;
+            }
+        }, context.limits.threads);
+
+        iteration.timedOut = iterationAborted.load();
+        iteration.score = bestScore;
+        return iteration;
+    }
+
+    // Iterative deepening over the ordered root moves, starting at 'firstDepth'. Each finished
+    // iteration widens every node (progressive widening) and moves its best move to the front.
+    // Stops at maxDepth, when the time budget runs out or when the context is aborted.
+    template <typename Profile>
+    Move iterateRoot(const GameState& rootState, std::vector<ScoredMove>& scored, SearchContext& context,
+        Profile profile, int firstDepth) {
+        const auto& limits = context.limits;
+        bool rootSplit = limits.parallelism == SearchParallelism::RootSplit && limits.threads > 1;
+        Move bestMove = scored.front().move;
+
+        for (int depth = firstDepth; depth <= limits.maxDepth; ++depth) {
+            std::size_t width = std::min(scored.size(), progressiveWidth(limits, depth));
+            auto iteration = rootSplit
+                ? searchRootParallel(rootState, scored, width, depth, context, profile)
+                : searchRootMoves(rootState, scored, width, depth, context, profile);
+
+            // A partial iteration is only trusted if it overturned the previous best (searched first)
+            if (!iteration.timedOut || iteration.bestIdx != 0) {
+                bestMove = scored[iteration.bestIdx].move;
+                std::rotate(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(iteration.bestIdx),
+                    scored.begin() + static_cast<std::ptrdiff_t>(iteration.bestIdx) + 1);
+            }
+
+            // Past half the budget the next, wider iteration would not finish anyway
+            if (iteration.timedOut || std::chrono::steady_clock::now() > limits.deadline - limits.timeBudget / 2) {
+                break;
+            }
+        }
+        return bestMove;
+    }
+
+    // Lazy SMP helper: same search, different shape. Odd helpers start one ply deeper and every
+    // helper rotates the leading root moves, so they fill the shared table ahead of the main thread.
+    template <typename Profile>
+    void runSearchHelper(unsigned helperId, const GameState& rootState, std::vector<ScoredMove> scored,
+        SearchContext context, Profile profile) {
+        try {
+            std::size_t rotation = std::min<std::size_t>(helperId % 4, scored.size() - 1);
+            std::rotate(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(rotation),
+                scored.begin() + static_cast<std::ptrdiff_t>(std::min<std::size_t>(scored.size(), 4)));
+            iterateRoot(rootState, scored, context, profile, 2 + static_cast<int>(helperId % 2));
+        }
+        catch (...) {
+            // Helpers never report: cancellation and errors surface through the main thread
+        }
+    }
+}
+
+namespace detail {
+
+    // Moves that need no search: book, perfect-play database, region solver and endgame prover, in
+    // that order. Returns an empty Move if none of them settles the position; time the prover used
+    // is taken off 'searchLimits.timeBudget' and 'searchStart' moves to now.
+    inline Move instantMove(const GameState& state, const SearchLimits& limits, const std::atomic_bool* cancel,
+        SearchLimits& searchLimits, std::chrono::steady_clock::time_point& searchStart) {
+        if (limits.useBook) {
+            Move bookMove = OpeningBook::instance().pick(state, limits.bookVariety);
+            if (bookMove.player != Player::None) {
+                return bookMove;
+            }
+        }
+        if (limits.perfectPlay) {
+            Move solvedMove = proof::perfectPlayBook().pick(state, false);
+            if (solvedMove.player != Player::None) {
+                return solvedMove;
+            }
+        }
+        if (limits.solveRegions) {
+            auto analysis = regions::RegionSolver().analyse(state);
+            if (analysis.settled && analysis.move.player != Player::None) {
+                return analysis.move;
+            }
+        }
+        if (limits.proofSquares > 0 && proof::contestedSquareCount(state) <= limits.proofSquares) {
+            auto outcome = proveEndgame(state, limits.proofNodes, searchStart + limits.timeBudget / 2, cancel,
+                limits.proofTableMegabytes);
+            if (outcome.result == ProofResult::Win) {
+                return outcome.move;
+            }
+            // Lost or unproven: search with what is left of the budget
+            auto now = std::chrono::steady_clock::now();
+            searchLimits.timeBudget -= std::chrono::duration_cast<std::chrono::milliseconds>(now - searchStart);
+            searchStart = now;
+        }
+        return {};
+    }
+
+    // Iterative deepening alpha-beta with the configured parallelism, using 'table' and, unless
+    // null, 'evalCache'. An entry the table already has for the root (from an earlier search) puts
+    // its move first.
+    template <typename Profile>
+    Move searchAlphaBeta(const GameState& state, const SearchLimits& searchLimits, Profile profile,
+        const std::atomic_bool* cancel, std::chrono::steady_clock::time_point searchStart, TranspositionTable& table,
+        EvalCache* evalCache) {
+        GameState rootState = state;
+        Player perspective = rootState.currentPlayer();
+        auto scored = orderRootMoves(rootState, perspective, profile, cancel, evalCache, searchLimits.neuralEval);
+
+        if (scored.empty()) {
+            return {};
+        }
+
+        SearchPosition rootPosition(rootState);
+        TableKey rootKey = tableKey(rootPosition, searchLimits.neuralEval);
+        TableEntry rootEntry;
+        if (table.probe(rootKey.hash, rootEntry)) {
+            // A half-move entry has no arrow; the best ordered move with its queen step stands in
+            TableMove hint = mapHint(rootEntry.move, rootKey, false);
+            auto hinted = std::find_if(scored.begin(), scored.end(), [&](const ScoredMove& candidate) {
+                return matchesSquare(rootPosition, candidate.move.queenFrom, hint.from)
+                    && matchesSquare(rootPosition, candidate.move.queenTo, hint.to)
+                    && (hint.arrow == TableMove::kNone || matchesSquare(rootPosition, candidate.move.arrow, hint.arrow));
+            });
+            if (hinted != scored.end()) {
+                std::rotate(scored.begin(), hinted, hinted + 1);
+            }
+        }
+
+        std::atomic_bool helpersDone{ false };
+        SearchContext context;
+        context.limits = searchLimits;
+        context.limits.deadline = searchStart + searchLimits.timeBudget;
+        context.table = &table;
+        context.evalCache = evalCache;
+        context.cancel = cancel;
+
+        std::unique_ptr<WorkStealingScheduler> scheduler;
+        if (searchLimits.parallelism == SearchParallelism::SplitPoints && searchLimits.threads > 1) {
+            scheduler = std::make_unique<WorkStealingScheduler>(searchLimits.threads);
+            context.scheduler = scheduler.get();
+        }
+
+        SearchContext helperContext = context;
+        helperContext.abort = &helpersDone;
+        std::vector<std::thread> helpers;
+        unsigned helperCount = searchLimits.parallelism == SearchParallelism::LazySmp ? searchLimits.threads : 1;
+        for (unsigned helperId = 1; helperId < helperCount; ++helperId) {
+            helpers.emplace_back(runSearchHelper<Profile>, helperId, std::cref(rootState), scored, helperContext, profile);
+        }
+
+        auto stopHelpers = [&]() {
+            helpersDone.store(true);
+            for (auto& helper : helpers) {
+                helper.join();
+            }
+        };
+
+        Move bestMove;
+        try {
+            bestMove = iterateRoot(rootState, scored, context, profile, 2);
+        }
+        catch (...) {
+            stopHelpers();
+            throw;
+        }
+        stopHelpers();
+        return bestMove;
+    }
+
+    // The same for the profile of 'difficulty': one specialised search per profile
+    inline Move searchAlphaBeta(const GameState& state, const SearchLimits& searchLimits, Difficulty difficulty,
+        const std::atomic_bool* cancel, std::chrono::steady_clock::time_point searchStart, TranspositionTable& table,
+        EvalCache* evalCache) {
+        return withProfile(difficulty, [&](auto profile) {
+            return searchAlphaBeta(state, searchLimits, profile, cancel, searchStart, table, evalCache);
+        });
+    }
+}
+
+// Defined in Mcts.h, included at the end of this file
+inline Move getBestMoveMcts(const GameState& state, const SearchLimits& limits, const std::atomic_bool* cancel);
+
+inline Move getBestMove(const GameState& state, const SearchLimits& limits, Difficulty difficulty,
+    const std::atomic_bool* cancel = nullptr) {
+    auto searchStart = std::chrono::steady_clock::now();
+    SearchLimits searchLimits = limits;
+    Move instant = detail::instantMove(state, limits, cancel, searchLimits, searchStart);
+    if (instant.player != Player::None) {
+        return instant;
+    }
+
+    if (searchLimits.engine == SearchEngine::MonteCarlo) {
+        return getBestMoveMcts(state, searchLimits, cancel);
+    }
+
+    TranspositionTable table(searchLimits.tableMegabytes);
+    std::unique_ptr<EvalCache> evalCache;
+    if (searchLimits.evalCacheMegabytes > 0) {
+        evalCache = std::make_unique<EvalCache>(searchLimits.evalCacheMegabytes);
+    }
+    return detail::searchAlphaBeta(state, searchLimits, difficulty, cancel, searchStart, table, evalCache.get());
+}
+
+inline Move getBestMove(const GameState& state, Difficulty difficulty, const std::atomic_bool* cancel = nullptr) {
+    return getBestMove(state, searchLimitsForDifficulty(difficulty), difficulty, cancel);
+}
+
+// One line of a multi-PV analysis. Scores are from the point of view of the side to move.
+struct AnalysisLine {
+    Move move;
+    int score = 0;
+    int depth = 0;                         // iteration the line comes from
+    std::vector<Move> principalVariation;  // starts with 'move'
+};
+
+namespace detail {
+
+    // Appends the moves the table remembers as best from 'position' on, up to 'maxTurns' of them.
+    // Half-move entries are followed through their arrow ply. Stops at the first missing or
+    // illegal hint; the position is restored on return. 'neural' as for tableKey.
+    inline void appendPrincipalVariation(SearchPosition& position, const TranspositionTable& table, int maxTurns,
+        bool neural, std::vector<Move>& line) {
+        std::size_t first = line.size();
+        for (int turn = 0; turn < maxTurns; ++turn) {
+            TableEntry entry;
+            TableKey key = tableKey(position, neural);
+            if (!table.probe(key.hash, entry)) {
+                break;
+            }
+            TableMove hint = mapHint(entry.move, key, false);
+            if (hint.from == TableMove::kNone || hint.to == TableMove::kNone) {
+                break;
+            }
+            Move move{ position.currentPlayer(), position.positionOf(hint.from), position.positionOf(hint.to), {} };
+            if (hint.arrow != TableMove::kNone) {
+                move.arrow = position.positionOf(hint.arrow);
+            }
+            else {
+                // The queen ply only knows the step; its arrow ply entry knows the shot
+                bool reachable = false;
+                forEachReachableSquare(position.board().tiles(), position.dimension(), hint.from, -1,
+                    [&](int square) { reachable = reachable || square == hint.to; });
+                if (position.board().tiles()[hint.from] != tileForPlayer(position.currentPlayer()) || !reachable) {
+                    break;
+                }
+                position.makeQueenStep(move.queenFrom, move.queenTo);
+                TableKey arrowKey = tableKey(position, neural);
+                TableEntry arrowEntry;
+                bool found = table.probe(arrowKey.hash, arrowEntry);
+                position.unmakeQueenStep(move.queenFrom, move.queenTo);
+                TableMove arrowHint = mapHint(arrowEntry.move, arrowKey, false);
+                if (!found || arrowHint.arrow == TableMove::kNone) {
+                    break;
+                }
+                move.arrow = position.positionOf(arrowHint.arrow);
+            }
+            if (!isMoveLegal(position.state(), move)) {
+                break;
+            }
+            position.makeMove(move);
+            line.push_back(move);
         }
+        for (std::size_t idx = line.size(); idx > first; --idx) {
+            position.unmakeMove(line[idx - 1]);
+        }
+    }
+}
+
+// Multi-PV analysis: the best 'lineCount' root moves with scores and principal variations, best
+// first. Every iteration of the deepening fixes its candidates, the best max(width, lineCount)
+// ordered root moves, and runs one pass per line over the candidates the earlier passes have not
+// taken. Candidates keep their late move reduction rank across passes, so each pass's best move
+// gets an exact score comparable with the others; all passes share one table.
+// Always an alpha-beta search; book, region solver and prover are not consulted.
+template <typename Profile>
+std::vector<AnalysisLine> analysePosition(const GameState& state, std::size_t lineCount, const SearchLimits& limits,
+    Profile profile, const std::atomic_bool* cancel = nullptr) {
+    std::vector<AnalysisLine> lines;
+    std::unique_ptr<EvalCache> evalCache;
+    if (limits.evalCacheMegabytes > 0) {
+        evalCache = std::make_unique<EvalCache>(limits.evalCacheMegabytes);
+    }
+    auto scored = detail::orderRootMoves(state, state.currentPlayer(), profile, cancel, evalCache.get(), limits.neuralEval);
+    lineCount = std::min(lineCount, scored.size());
+    if (lineCount == 0) {
+        return lines;
+    }
+
+    TranspositionTable table(limits.tableMegabytes);
+    SearchContext context;
+    context.limits = limits;
+    context.limits.deadline = std::chrono::steady_clock::now() + limits.timeBudget;
+    context.table = &table;
+    context.evalCache = evalCache.get();
+    context.cancel = cancel;
+
+    std::unique_ptr<WorkStealingScheduler> scheduler;
+    if (limits.parallelism == SearchParallelism::SplitPoints && limits.threads > 1) {
+        scheduler = std::make_unique<WorkStealingScheduler>(limits.threads);
+        context.scheduler = scheduler.get();
     }
 
-    return bestMove;
+    for (int depth = 2; depth <= limits.maxDepth; ++depth) {
+        std::size_t width = std::min(scored.size(), std::max(detail::progressiveWidth(limits, depth), lineCount));
+        std::vector<detail::ScoredMove> remaining(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(width));
+        std::vector<std::size_t> ranks(width);
+        std::iota(ranks.begin(), ranks.end(), std::size_t{ 0 });
+
+        std::vector<AnalysisLine> found;
+        bool timedOut = false;
+        while (found.size() < lineCount) {
+            auto iteration = detail::searchRootMoves(state, remaining, remaining.size(), depth, context, profile, &ranks);
+            if (iteration.timedOut) {
+                timedOut = true;
+                break;
+            }
+
+            AnalysisLine line;
+            line.move = remaining[iteration.bestIdx].move;
+            line.score = iteration.score;
+            line.depth = depth;
+            line.principalVariation.push_back(line.move);
+            SearchPosition position(state);
+            position.makeMove(line.move);
+            detail::appendPrincipalVariation(position, table, depth - 1, limits.neuralEval, line.principalVariation);
+            found.push_back(std::move(line));
+            remaining.erase(remaining.begin() + static_cast<std::ptrdiff_t>(iteration.bestIdx));
+            ranks.erase(ranks.begin() + static_cast<std::ptrdiff_t>(iteration.bestIdx));
+        }
+        std::stable_sort(found.begin(), found.end(), [](const AnalysisLine& a, const AnalysisLine& b) { return a.score > b.score; });
+
+        // An unfinished iteration only counts if nothing deeper is there yet
+        if (!timedOut || lines.empty()) {
+            lines = std::move(found);
+        }
+        if (timedOut || std::chrono::steady_clock::now() > context.limits.deadline - limits.timeBudget / 2) {
+            break;
+        }
+
+        // The next iteration searches this one's lines first, in order
+        std::stable_partition(scored.begin(), scored.end(), [&](const detail::ScoredMove& candidate) {
+            return std::any_of(lines.begin(), lines.end(), [&](const AnalysisLine& line) { return line.move == candidate.move; });
+        });
+        std::stable_sort(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(lines.size()),
+            [&](const detail::ScoredMove& a, const detail::ScoredMove& b) {
+                auto rank = [&](const Move& move) {
+                    return std::find_if(lines.begin(), lines.end(), [&](const AnalysisLine& line) { return line.move == move; }) - lines.begin();
+                };
+                return rank(a.move) < rank(b.move);
+            });
+    }
+    return lines;
 }
+
+inline std::vector<AnalysisLine> analysePosition(const GameState& state, std::size_t lineCount, const SearchLimits& limits,
+    Difficulty difficulty, const std::atomic_bool* cancel = nullptr) {
+    return withProfile(difficulty, [&](auto profile) { return analysePosition(state, lineCount, limits, profile, cancel); });
+}
+
+#include "Mcts.h"
@@ -0,0 +1,513 @@
+#pragma once
+
+#include "DistanceMap.h"
+#include "EvalWeights.h"
+#include "GameState.h"
+#include "IncrementalEval.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Hand-written evaluation terms of many positions at once, for root move ordering and offline
+// tuning. Positions are stored in blocks of kLanes, structure of arrays: a mask of a block holds
+// one bitboard (distance:: layout) per position in one vector register, so every bit operation
+// below runs on all of them at once. Mobility and queen reach come from slides over those masks;
+// the territory term's per-square comparisons become bit-sliced arithmetic on the distances of
+// all squares together, and its sums population counts. The terms equal what evaluate() adds up.
+namespace batch {
+
+    // As many 64-bit lanes as a vector register holds; wider blocks only spill registers
+#if defined(__AVX2__)
+    inline constexpr std::size_t kLanes = 4;
+#else
+    inline constexpr std::size_t kLanes = 2;
+#endif
+    inline constexpr std::size_t kMaxQueens = 4;
+
+#if defined(__GNUC__)
+    // One 64-bit word per lane, a vector register with GCC and Clang. Never returned bare from a
+    // function: that would change the ABI with the target.
+    using Lanes = std::uint64_t __attribute__((vector_size(kLanes * sizeof(std::uint64_t))));
+#else
+    // The same, word by word, for compilers without vector extensions
+    struct Lanes {
+        std::array<std::uint64_t, kLanes> words{};
+
+        std::uint64_t& operator[](std::size_t lane) { return words[lane]; }
+        std::uint64_t operator[](std::size_t lane) const { return words[lane]; }
+
+        template <typename Op>
+        friend Lanes apply(const Lanes& a, const Lanes& b, Op op) {
+            Lanes out;
+            for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                out.words[lane] = op(a.words[lane], b.words[lane]);
+            }
+            return out;
+        }
+
+        friend Lanes operator&(const Lanes& a, const Lanes& b) { return apply(a, b, [](std::uint64_t x, std::uint64_t y) { return x & y; }); }
+        friend Lanes operator|(const Lanes& a, const Lanes& b) { return apply(a, b, [](std::uint64_t x, std::uint64_t y) { return x | y; }); }
+        friend Lanes operator^(const Lanes& a, const Lanes& b) { return apply(a, b, [](std::uint64_t x, std::uint64_t y) { return x ^ y; }); }
+        friend Lanes operator+(const Lanes& a, const Lanes& b) { return apply(a, b, [](std::uint64_t x, std::uint64_t y) { return x + y; }); }
+        friend Lanes operator-(const Lanes& a, const Lanes& b) { return apply(a, b, [](std::uint64_t x, std::uint64_t y) { return x - y; }); }
+        friend Lanes operator+(const Lanes& a, std::uint64_t b) { return apply(a, a, [b](std::uint64_t x, std::uint64_t) { return x + b; }); }
+        friend Lanes operator&(const Lanes& a, std::uint64_t b) { return apply(a, a, [b](std::uint64_t x, std::uint64_t) { return x & b; }); }
+        friend Lanes operator<<(const Lanes& a, int bits) { return apply(a, a, [bits](std::uint64_t x, std::uint64_t) { return x << bits; }); }
+        friend Lanes operator>>(const Lanes& a, int bits) { return apply(a, a, [bits](std::uint64_t x, std::uint64_t) { return x >> bits; }); }
+        friend Lanes operator~(const Lanes& a) { return apply(a, a, [](std::uint64_t x, std::uint64_t) { return ~x; }); }
+        Lanes& operator+=(const Lanes& other) { return *this = *this + other; }
+        Lanes& operator-=(const Lanes& other) { return *this = *this - other; }
+    };
+#endif
+
+    // One bitboard per lane: bits 0-63 in 'low', 64-127 in 'high'
+    struct Masks {
+        Lanes low{};
+        Lanes high{};
+    };
+
+    inline Masks operator&(const Masks& a, const Masks& b) { return { a.low & b.low, a.high & b.high }; }
+    inline Masks operator|(const Masks& a, const Masks& b) { return { a.low | b.low, a.high | b.high }; }
+    inline Masks operator^(const Masks& a, const Masks& b) { return { a.low ^ b.low, a.high ^ b.high }; }
+    inline Masks operator~(const Masks& a) { return { ~a.low, ~a.high }; }
+
+    inline bool any(const Masks& masks) {
+        Lanes bits = masks.low | masks.high;
+        std::uint64_t all = 0;
+        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+            all |= bits[lane];
+        }
+        return all != 0;
+    }
+
+    // distance::Bitboard::shifted on every lane
+    inline Masks shifted(const Masks& masks, int amount) {
+        if (amount >= 64) {
+            return { Lanes{}, masks.low << (amount - 64) };
+        }
+        if (amount > 0) {
+            return { masks.low << amount, (masks.high << amount) | (masks.low >> (64 - amount)) };
+        }
+        if (amount <= -64) {
+            return { masks.high >> (-amount - 64), Lanes{} };
+        }
+        if (amount < 0) {
+            return { (masks.low >> -amount) | (masks.high << (64 + amount)), masks.high >> -amount };
+        }
+        return masks;
+    }
+
+    // Adds the number of set bits of each lane to 'counts', bit-parallel: the popcount
+    // instruction has no vector form before AVX-512
+    inline void addCount(Lanes& counts, const Masks& masks) {
+        Lanes low = masks.low - ((masks.low >> 1) & 0x5555555555555555ull);
+        Lanes high = masks.high - ((masks.high >> 1) & 0x5555555555555555ull);
+        low = (low & 0x3333333333333333ull) + ((low >> 2) & 0x3333333333333333ull);
+        high = (high & 0x3333333333333333ull) + ((high >> 2) & 0x3333333333333333ull);
+        Lanes bytes = ((low + (low >> 4)) & 0x0F0F0F0F0F0F0F0Full) + ((high + (high >> 4)) & 0x0F0F0F0F0F0F0F0Full);
+        bytes += bytes >> 8;
+        bytes += bytes >> 16;
+        bytes += bytes >> 32;
+        counts += bytes & 0xFF;
+    }
+
+    // Terms of one position from the evaluating side's view, unweighted
+    struct Terms {
+        int mobility = 0;   // detail::mobilityCount difference
+        int spatial = 0;    // detail::spatialInfluenceScore
+        int territory = 0;  // detail::territoryScore
+    };
+
+    // Positions laid out for the kernels. Positions of one board size share a block; one of
+    // another size than the last starts a new block, so batches are best filled size by size.
+    class PositionBatch {
+    public:
+        struct Block {
+            int dim = 0;
+            std::size_t first = 0;  // batch index of lane 0
+            std::size_t count = 0;  // lanes in use
+            Masks empty;
+            std::array<std::array<Masks, kMaxQueens>, 2> queens;  // one queen per mask, by side
+            std::array<std::array<int, kLanes>, 2> centrality{};  // IncrementalEval::centrality, by side
+            std::array<Player, kLanes> toMove{};
+        };
+
+        void reserve(std::size_t positions) {
+            _blocks.reserve(positions / kLanes + 1);
+            _finished.reserve(positions);
+            _winner.reserve(positions);
+        }
+
+        void add(const GameState& state) {
+            int dim = state.board().dimension();
+            if (_blocks.empty() || _blocks.back().count == kLanes || _blocks.back().dim != dim) {
+                _blocks.emplace_back();
+                _blocks.back().dim = dim;
+                _blocks.back().first = _size;
+            }
+            Block& block = _blocks.back();
+            std::size_t lane = block.count++;
+
+            int stride = dim + 1;
+            const auto& tiles = state.board().tiles();
+            std::array<std::uint64_t, 2> empty{};
+            for (int row = 0; row < dim; ++row) {
+                std::uint64_t rowBits = 0;
+                for (int col = 0; col < dim; ++col) {
+                    rowBits |= std::uint64_t{ tiles[static_cast<std::size_t>(row * dim + col)] == TileContent::Empty } << col;
+                }
+                int bit = row * stride;
+                empty[0] |= bit < 64 ? rowBits << bit : 0;
+                empty[1] |= bit >= 64 ? rowBits << (bit - 64) : (bit > 0 ? rowBits >> (64 - bit) : 0);
+            }
+            block.empty.low[lane] = empty[0];
+            block.empty.high[lane] = empty[1];
+            for (std::size_t side = 0; side < 2; ++side) {
+                const auto& queens = state.queenPositions(side == 0 ? Player::White : Player::Black);
+                for (std::size_t idx = 0; idx < std::min(queens.size(), kMaxQueens); ++idx) {
+                    std::array<std::uint64_t, 2> queen{};
+                    set(queen, queens[idx].row * stride + queens[idx].col);
+                    block.queens[side][idx].low[lane] = queen[0];
+                    block.queens[side][idx].high[lane] = queen[1];
+                    block.centrality[side][lane] += IncrementalEval::centrality(dim, queens[idx].row * dim + queens[idx].col);
+                }
+            }
+            block.toMove[lane] = state.currentPlayer();
+            _finished.push_back(state.isFinished());
+            _winner.push_back(state.winner());
+            ++_size;
+        }
+
+        void clear() {
+            _blocks.clear();
+            _finished.clear();
+            _winner.clear();
+            _size = 0;
+        }
+
+        [[nodiscard]] std::size_t size() const { return _size; }
+        [[nodiscard]] const std::vector<Block>& blocks() const { return _blocks; }
+        // Finished positions get no terms; evaluate() scores them by their winner
+        [[nodiscard]] bool finished(std::size_t idx) const { return _finished[idx] != 0; }
+        [[nodiscard]] Player winner(std::size_t idx) const { return _winner[idx]; }
+
+    private:
+        std::vector<Block> _blocks;
+        std::vector<char> _finished;
+        std::vector<Player> _winner;
+        std::size_t _size = 0;
+
+        static void set(std::array<std::uint64_t, 2>& words, int bit) {
+            words[static_cast<std::size_t>(bit / 64)] |= std::uint64_t{ 1 } << (bit % 64);
+        }
+    };
+
+    namespace kernels {
+
+        // Empty squares of a block with the runs a slide along each direction passes through:
+        // runs[dir][n] holds the squares starting 2^n empty squares in a row (distance::slide)
+        struct Slider {
+            std::array<int, 8> steps{};
+            std::array<std::array<Masks, 4>, 8> runs;
+
+            Slider(const Masks& empty, int stride)
+                : steps{ 1, -1, stride, -stride, stride + 1, stride - 1, -stride + 1, -stride - 1 }
+            {
+                for (std::size_t dir = 0; dir < steps.size(); ++dir) {
+                    runs[dir][0] = empty;
+                    for (std::size_t stage = 1; stage < 4; ++stage) {
+                        runs[dir][stage] = runs[dir][stage - 1] & shifted(runs[dir][stage - 1], steps[dir] * (1 << (stage - 1)));
+                    }
+                }
+            }
+
+            [[nodiscard]] const Masks& empty() const { return runs[0][0]; }
+
+            // Empty squares one queen move from 'from'
+            [[nodiscard]] Masks queenStep(const Masks& from) const {
+                Masks reached;
+                for (std::size_t dir = 0; dir < steps.size(); ++dir) {
+                    Masks line = from;
+                    for (std::size_t stage = 0; stage < 4; ++stage) {
+                        line = line | (runs[dir][stage] & shifted(line, steps[dir] * (1 << stage)));
+                    }
+                    reached = reached | shifted(line, steps[dir]);
+                }
+                return reached & empty();
+            }
+
+            // Empty squares one king step from 'from'
+            [[nodiscard]] Masks kingStep(const Masks& from) const {
+                Masks reached;
+                for (int step : steps) {
+                    reached = reached | shifted(from, step);
+                }
+                return reached & empty();
+            }
+        };
+
+        // Legal moves of one side, queen step then arrow, and the squares its queens reach in
+        // one move (IncrementalEval::mobility). Moves are capped like detail::mobilityCount,
+        // whose cap only stops the counting early: here once every lane is past it.
+        inline void mobility(const PositionBatch::Block& block, const Slider& slider, std::size_t side,
+            std::array<std::int64_t, kLanes>& moves, Lanes& reach) {
+            constexpr std::int64_t kMobilitySample = 48;
+            Lanes count{};
+            for (std::size_t lane = block.count; lane < kLanes; ++lane) {
+                count[lane] = kMobilitySample;  // unused
+            }
+            auto capped = [&]() {
+                for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                    if (count[lane] < static_cast<std::uint64_t>(kMobilitySample)) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            for (const Masks& queen : block.queens[side]) {
+                Masks targets = slider.queenStep(queen);
+                addCount(reach, targets);
+                // Arrows fly through the square the queen left: every (target, arrow) pair along
+                // each direction, one arrow distance at a time
+                Masks through = slider.empty() | queen;
+                for (std::size_t dir = 0; dir < slider.steps.size() && !capped(); ++dir) {
+                    int step = slider.steps[dir];
+                    for (Masks arrows = shifted(targets, step) & through; any(arrows); arrows = shifted(arrows, step) & through) {
+                        addCount(count, arrows);
+                    }
+                }
+            }
+            for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                moves[lane] = std::min(static_cast<std::int64_t>(count[lane]), kMobilitySample);
+            }
+        }
+
+        // Steps from one side's queens to every empty square, bit sliced: bit n of the distance
+        // of each square in bits[n]; squares out of reach get kFar
+        inline constexpr std::size_t kDistanceBits = 7;
+        inline constexpr int kFar = (1 << kDistanceBits) - 1;
+
+        struct Distances {
+            std::array<Masks, kDistanceBits> bits;
+            Masks reached;
+            int layers = 0;  // largest finite distance over the lanes
+        };
+
+        // Multi-source BFS, a layer per step; 'layer(steps, squares)' sees each layer
+        template <typename Step, typename Layer>
+        void fillDistances(const Masks& sources, const Masks& empty, Step step, Distances& distances, Layer layer) {
+            distances = Distances{};
+            Masks frontier = sources;
+            for (int steps = 1; ; ++steps) {
+                frontier = step(frontier) & ~distances.reached;
+                if (!any(frontier)) {
+                    break;
+                }
+                distances.reached = distances.reached | frontier;
+                for (std::size_t bit = 0; bit < kDistanceBits; ++bit) {
+                    if ((steps >> bit) & 1) {
+                        distances.bits[bit] = distances.bits[bit] | frontier;
+                    }
+                }
+                distances.layers = steps;
+                layer(steps, frontier);
+            }
+            Masks far = empty & ~distances.reached;
+            for (auto& bits : distances.bits) {
+                bits = bits | far;
+            }
+        }
+
+        // a - b square by square, as two's complement with a sign bit on top
+        inline std::array<Masks, kDistanceBits + 1> subtract(const Distances& a, const Distances& b) {
+            std::array<Masks, kDistanceBits + 1> difference;
+            Masks carry = ~Masks{};
+            for (std::size_t bit = 0; bit <= kDistanceBits; ++bit) {
+                Masks x = bit < kDistanceBits ? a.bits[bit] : Masks{};
+                Masks y = ~(bit < kDistanceBits ? b.bits[bit] : Masks{});
+                difference[bit] = x ^ y ^ carry;
+                carry = (x & y) | (carry & (x ^ y));
+            }
+            return difference;
+        }
+
+        // Per-lane sums of min(difference, cap) over the squares of 'where', all of them with a
+        // positive difference
+        inline void addCapped(Lanes& sums, const std::array<Masks, kDistanceBits + 1>& difference, const Masks& where) {
+            // The cap is 6: at least 8, or 6 or 7
+            static_assert(distance::TerritorySums::kKingDistanceCap == 6);
+            Masks atCap = difference[3] | difference[4] | difference[5] | difference[6] | (difference[2] & difference[1]);
+            Masks below = where & ~atCap;
+            Lanes ones{}, twos{}, fours{}, sixes{};
+            addCount(ones, below & difference[0]);
+            addCount(twos, below & difference[1]);
+            addCount(fours, below & difference[2]);
+            addCount(sixes, where & atCap);
+            sums += ones + (twos << 1) + (fours << 2) + (sixes << 2) + (sixes << 1);
+        }
+
+        // Squares where a distance lead is positive, negative and zero
+        struct Comparison {
+            Masks ahead, behind, level;
+        };
+
+        inline Comparison compare(const std::array<Masks, kDistanceBits + 1>& lead) {
+            Masks nonzero;
+            for (const Masks& bits : lead) {
+                nonzero = nonzero | bits;
+            }
+            const Masks& negative = lead[kDistanceBits];
+            return { nonzero & ~negative, negative, ~nonzero };
+        }
+
+        // Who reaches each square first: squares 'own' wins, loses and ties on
+        struct Ownership {
+            Lanes wins{}, losses{}, ties{};
+
+            Ownership(const Comparison& comparison, const Masks& ownReached) {
+                addCount(wins, comparison.ahead);
+                addCount(losses, comparison.behind);
+                addCount(ties, comparison.level & ownReached);
+            }
+        };
+
+        inline std::int64_t signedLane(const Lanes& lanes, std::size_t lane) { return static_cast<std::int64_t>(lanes[lane]); }
+
+        // detail::territoryScore of each lane from side 'own's view
+        inline void territory(const PositionBatch::Block& block, const Slider& slider, std::size_t own,
+            std::array<int, kLanes>& scores) {
+            using Sums = distance::TerritorySums;
+
+            // Closeness 2^-steps weighs whole layers
+            std::array<std::int64_t, kLanes> queenCloseness{};
+            std::array<Distances, 2> queenDistances, kingDistances;
+            for (std::size_t side = 0; side < 2; ++side) {
+                Masks sources;
+                for (const Masks& queen : block.queens[side]) {
+                    sources = sources | queen;
+                }
+                std::int64_t sign = side == own ? 1 : -1;
+                fillDistances(sources, slider.empty(), [&](const Masks& from) { return slider.queenStep(from); }, queenDistances[side],
+                    [&](int steps, const Masks& layer) {
+                        Lanes count{};
+                        addCount(count, layer);
+                        std::int64_t weight = sign * Sums::closeness(steps);
+                        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                            queenCloseness[lane] += weight * signedLane(count, lane);
+                        }
+                    });
+                fillDistances(sources, slider.empty(), [&](const Masks& from) { return slider.kingStep(from); }, kingDistances[side],
+                    [](int, const Masks&) {});
+            }
+            const Distances& ownQueen = queenDistances[own];
+            const Distances& otherQueen = queenDistances[1 - own];
+            const Distances& ownKing = kingDistances[own];
+            const Distances& otherKing = kingDistances[1 - own];
+
+            // Distance leads: positive where 'own' is closer
+            auto queenLead = subtract(otherQueen, ownQueen);
+            auto queenLag = subtract(ownQueen, otherQueen);
+            auto kingLead = subtract(otherKing, ownKing);
+            auto kingLag = subtract(ownKing, otherKing);
+
+            Comparison queenComparison = compare(queenLead);
+            Comparison kingComparison = compare(kingLead);
+            Ownership queenOwnership(queenComparison, ownQueen.reached);
+            Ownership kingOwnership(kingComparison, ownKing.reached);
+
+            // King distance difference clamped to the cap, both ways
+            Lanes kingAhead{}, kingBehind{};
+            addCapped(kingAhead, kingLead, kingComparison.ahead);
+            addCapped(kingBehind, kingLag, kingComparison.behind);
+
+            // Contact 2^-|difference| where both sides get to
+            std::array<std::int64_t, kLanes> contact{};
+            Masks both = ownQueen.reached & otherQueen.reached;
+            std::array<Masks, kDistanceBits> gap;
+            for (std::size_t bit = 0; bit < kDistanceBits; ++bit) {
+                gap[bit] = (queenComparison.behind & queenLag[bit]) | (~queenComparison.behind & queenLead[bit]);
+            }
+            int widest = std::max(ownQueen.layers, otherQueen.layers);
+            for (int steps = 0; steps < widest; ++steps) {
+                Masks equal = both;
+                for (std::size_t bit = 0; bit < kDistanceBits; ++bit) {
+                    equal = equal & ((steps >> bit) & 1 ? gap[bit] : ~gap[bit]);
+                }
+                Lanes count{};
+                addCount(count, equal);
+                for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                    contact[lane] += Sums::closeness(steps) * signedLane(count, lane);
+                }
+            }
+
+            Lanes empty{};
+            addCount(empty, slider.empty());
+            Player player = own == 0 ? Player::White : Player::Black;
+            for (std::size_t lane = 0; lane < block.count; ++lane) {
+                Sums sums;
+                sums.empty = static_cast<int>(empty[lane]);
+                sums.queenOwned = static_cast<int>(signedLane(queenOwnership.wins, lane) - signedLane(queenOwnership.losses, lane));
+                sums.queenTied = static_cast<int>(queenOwnership.ties[lane]);
+                sums.kingOwned = static_cast<int>(signedLane(kingOwnership.wins, lane) - signedLane(kingOwnership.losses, lane));
+                sums.kingTied = static_cast<int>(kingOwnership.ties[lane]);
+                sums.kingLead = static_cast<int>(signedLane(kingAhead, lane) - signedLane(kingBehind, lane));
+                sums.queenCloseness = queenCloseness[lane];
+                sums.contact = contact[lane];
+                scores[lane] = sums.score(block.toMove[lane] == player);
+            }
+        }
+
+        template <typename Profile>
+        void evaluateBlock(const PositionBatch::Block& block, Player perspective, Terms* terms) {
+            Slider slider(block.empty, block.dim + 1);
+            std::size_t own = perspective == Player::White ? 0 : 1;
+
+            std::array<std::array<std::int64_t, kLanes>, 2> moves{};
+            std::array<Lanes, 2> reach{};
+            for (std::size_t side = 0; side < 2; ++side) {
+                mobility(block, slider, side, moves[side], reach[side]);
+            }
+            std::array<int, kLanes> territoryScores{};
+            if constexpr (Profile::kTerritory) {
+                territory(block, slider, own, territoryScores);
+            }
+
+            constexpr std::int64_t kOne = IncrementalEval::kCentralityOne;
+            for (std::size_t lane = 0; lane < block.count; ++lane) {
+                Terms& out = terms[lane];
+                out.mobility = static_cast<int>(moves[own][lane] - moves[1 - own][lane]);
+                if constexpr (Profile::kSpatial) {
+                    auto positionalValue = [&](std::size_t side) {
+                        return signedLane(reach[side], lane) * (kOne / 4) + block.centrality[side][lane] * 10;
+                    };
+                    out.spatial = static_cast<int>((positionalValue(own) - positionalValue(1 - own)) / kOne);
+                }
+                out.territory = territoryScores[lane];
+            }
+        }
+    }
+
+    // Terms of every position of 'batch' from 'perspective' (those 'Profile' leaves out stay 0),
+    // block by block on up to 'threads' threads of 'pool'
+    template <typename Profile>
+    void evaluateTerms(const PositionBatch& batch, Player perspective, Profile, std::vector<Terms>& terms,
+        unsigned threads = 1, ThreadPool& pool = ThreadPool::shared()) {
+        terms.assign(batch.size(), Terms{});
+        const auto& blocks = batch.blocks();
+        auto run = [&](std::size_t idx) {
+            kernels::evaluateBlock<Profile>(blocks[idx], perspective, terms.data() + blocks[idx].first);
+        };
+        if (threads <= 1 || blocks.size() <= 1) {
+            for (std::size_t idx = 0; idx < blocks.size(); ++idx) {
+                run(idx);
+            }
+            return;
+        }
+        pool.run(blocks.size(), [&](std::size_t idx, unsigned) { run(idx); }, threads);
+    }
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+#include "OpeningBook.h"
+#include "ProofSearch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Whole-board solving (tools/Solve6x6.cpp): df-pn from the start position with a table that spills
+// proven entries to disk and checkpoints, and extraction of the resulting perfect-play database.
+namespace proof {
+
+    // Proven entries evicted from RAM, kept in a fixed-size file of buckets. An in-memory filter
+    // with one bit per slot answers most lookups of keys that were never spilled without a read.
+    class SpillFile {
+    public:
+        bool open(const std::string& path, std::size_t megabytes, bool resume) {
+            std::size_t buckets = 1;
+            while (buckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+                buckets *= 2;
+            }
+            _bucketMask = buckets - 1;
+            _filter.assign(buckets * kBucketSlots / 64 + 1, 0);
+            _count = 0;
+
+            if (resume) {
+                _file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+            }
+            if (!_file.is_open()) {
+                resume = false;
+                _file.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+            }
+            if (!_file.is_open()) {
+                return false;
+            }
+            if (!resume) {
+                // Sized up front; unwritten records read back as empty (key 0)
+                _file.seekp(static_cast<std::streamoff>(buckets * sizeof(Bucket) - 1));
+                _file.put('\0');
+                return static_cast<bool>(_file.flush());
+            }
+
+            Bucket bucket;
+            for (std::size_t index = 0; index < buckets; ++index) {
+                if (!read(index, bucket)) {
+                    return false;
+                }
+                for (const auto& record : bucket.records) {
+                    if (record.key != 0) {
+                        setFilter(record.key);
+                        ++_count;
+                    }
+                }
+            }
+            return true;
+        }
+
+        bool lookup(std::uint64_t key, Numbers& numbers) {
+            if (!testFilter(key)) {
+                return false;
+            }
+            Bucket bucket;
+            if (!read(key & _bucketMask, bucket)) {
+                return false;
+            }
+            for (const auto& record : bucket.records) {
+                if (record.key == key) {
+                    numbers = record.numbers;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Takes the key's own slot or a free one; a full bucket loses one of its entries
+        void store(std::uint64_t key, Numbers numbers) {
+            std::size_t index = key & _bucketMask;
+            Bucket bucket;
+            if (!read(index, bucket)) {
+                return;
+            }
+            std::size_t slot = static_cast<std::size_t>(key >> 61);
+            for (std::size_t idx = 0; idx < kBucketSlots; ++idx) {
+                if (bucket.records[idx].key == key || bucket.records[idx].key == 0) {
+                    slot = idx;
+                    break;
+                }
+            }
+            if (bucket.records[slot].key == 0) {
+                ++_count;
+            }
+            Record record{ key, numbers };
+            _file.seekp(static_cast<std::streamoff>(index * sizeof(Bucket) + slot * sizeof(Record)));
+            _file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            setFilter(key);
+        }
+
+        bool flush() { return static_cast<bool>(_file.flush()); }
+
+        [[nodiscard]] std::uint64_t count() const { return _count; }
+
+    private:
+        static constexpr std::size_t kBucketSlots = 8;
+
+        struct Record {
+            std::uint64_t key = 0;
+            Numbers numbers;
+        };
+
+        struct Bucket {
+            Record records[kBucketSlots];
+        };
+
+        std::fstream _file;
+        std::size_t _bucketMask = 0;
+        std::vector<std::uint64_t> _filter;
+        std::uint64_t _count = 0;
+
+        bool read(std::size_t index, Bucket& bucket) {
+            _file.seekg(static_cast<std::streamoff>(index * sizeof(Bucket)));
+            _file.read(reinterpret_cast<char*>(&bucket), sizeof(bucket));
+            if (!_file) {
+                _file.clear();
+                return false;
+            }
+            return true;
+        }
+
+        std::size_t filterBit(std::uint64_t key) const { return (key >> 20) % (_filter.size() * 64); }
+        void setFilter(std::uint64_t key) { _filter[filterBit(key) / 64] |= std::uint64_t{ 1 } << (filterBit(key) % 64); }
+        bool testFilter(std::uint64_t key) const { return (_filter[filterBit(key) / 64] >> (filterBit(key) % 64)) & 1; }
+    };
+
+    // Proof table for runs that outgrow RAM: always-replace in memory like ProofTable, except that
+    // proven entries are moved to the spill file when evicted instead of being lost
+    class DiskProofTable {
+    public:
+        DiskProofTable(std::size_t megabytes, SpillFile& spill)
+            : _spill(spill)
+        {
+            std::size_t entries = 1;
+            while (entries * 2 * sizeof(Entry) <= megabytes * 1024 * 1024) {
+                entries *= 2;
+            }
+            _entries = std::make_unique<Entry[]>(entries);
+            _mask = entries - 1;
+        }
+
+        [[nodiscard]] Numbers lookup(std::uint64_t key) {
+            const auto& entry = _entries[key & _mask];
+            if (entry.key == key) {
+                return entry.numbers;
+            }
+            Numbers numbers;
+            _spill.lookup(key, numbers);
+            return numbers;
+        }
+
+        void store(std::uint64_t key, Numbers numbers) {
+            auto& entry = _entries[key & _mask];
+            if (entry.key != key && entry.key != 0 && (entry.numbers.phi == 0 || entry.numbers.delta == 0)) {
+                _spill.store(entry.key, entry.numbers);
+            }
+            entry = { key, numbers };
+        }
+
+        // Writes the in-memory entries next to 'path' and then renames, so an interrupted
+        // checkpoint leaves the previous one intact. The spill file is flushed first.
+        bool saveCheckpoint(const std::string& path, std::uint64_t rootKey) {
+            if (!_spill.flush()) {
+                return false;
+            }
+            CheckpointHeader header{};
+            std::memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+            header.version = kCheckpointVersion;
+            header.rootKey = rootKey;
+            for (std::size_t idx = 0; idx <= _mask; ++idx) {
+                header.entries += _entries[idx].key != 0;
+            }
+
+            std::string temporary = path + ".tmp";
+            {
+                std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+                out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                for (std::size_t idx = 0; idx <= _mask; ++idx) {
+                    if (_entries[idx].key != 0) {
+                        out.write(reinterpret_cast<const char*>(&_entries[idx]), sizeof(Entry));
+                    }
+                }
+                if (!out.flush()) {
+                    return false;
+                }
+            }
+            std::remove(path.c_str());
+            return std::rename(temporary.c_str(), path.c_str()) == 0;
+        }
+
+        // Restores a checkpoint of the same root; the table size may differ from the saving run
+        bool loadCheckpoint(const std::string& path, std::uint64_t rootKey) {
+            std::ifstream in(path, std::ios::binary);
+            CheckpointHeader header{};
+            if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+                || std::memcmp(header.magic, kCheckpointMagic, sizeof(header.magic)) != 0
+                || header.version != kCheckpointVersion || header.rootKey != rootKey) {
+                return false;
+            }
+            Entry entry;
+            for (std::uint64_t idx = 0; idx < header.entries && in.read(reinterpret_cast<char*>(&entry), sizeof(entry)); ++idx) {
+                store(entry.key, entry.numbers);
+            }
+            return true;
+        }
+
+    private:
+        struct Entry {
+            std::uint64_t key = 0;
+            Numbers numbers;
+        };
+
+        struct CheckpointHeader {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t reserved;
+            std::uint64_t rootKey;
+            std::uint64_t entries;
+        };
+
+        static constexpr char kCheckpointMagic[8] = { 'A', 'M', 'Z', 'P', 'N', 'C', 'K', '1' };
+        static constexpr std::uint32_t kCheckpointVersion = 1;
+
+        SpillFile& _spill;
+        std::unique_ptr<Entry[]> _entries;
+        std::size_t _mask = 0;
+    };
+
+    // Perfect-play database: the winning move of every position on the proof tree where the winner
+    // is to move, stored in the opening book format. Settled positions are left to the region solver.
+    // Positions whose entry was lost are proven again with 'nodesPerGap'; 'gaps' counts failures.
+    template <typename Table>
+    std::vector<BookEntry> extractPerfectPlay(const GameState& root, Table& table, std::uint64_t nodesPerGap, std::uint64_t& gaps) {
+        std::vector<BookEntry> entries;
+        std::unordered_set<std::uint64_t> visited;
+        std::vector<GameState> pending{ root };
+        regions::RegionSolver regionSolver;
+        gaps = 0;
+
+        while (!pending.empty()) {
+            GameState state = std::move(pending.back());
+            pending.pop_back();
+            // Book entries are canonical, so one image of each position is enough
+            int sym = 0;
+            if (!visited.insert(zobrist::canonicalHashOf(state, sym)).second || regionSolver.analyse(state).settled) {
+                continue;
+            }
+            std::uint64_t key = zobrist::hashOf(state);
+
+            Numbers numbers = table.lookup(key);
+            if (numbers.phi != 0 && numbers.delta != 0) {
+                Prover<Table> prover(table, nodesPerGap, std::chrono::steady_clock::time_point::max(), nullptr);
+                prover.prove(state);
+                numbers = table.lookup(key);
+            }
+
+            auto moves = generateMovesForPlayer(state, state.currentPlayer());
+            if (numbers.phi == 0) {
+                SearchPosition position(state, false);
+                auto winning = std::find_if(moves.begin(), moves.end(), [&](const Move& move) {
+                    return table.lookup(position.hashAfter(move)).delta == 0;
+                });
+                if (winning == moves.end()) {
+                    ++gaps;
+                    continue;
+                }
+                entries.push_back(OpeningBook::entryFor(state, *winning, 1));
+                moves = { *winning };
+            }
+            else if (numbers.delta != 0) {
+                ++gaps;
+                continue;
+            }
+
+            // The winner's single move, or every defence of the losing side
+            for (const auto& move : moves) {
+                GameState child = state;
+                applyMove(child, move);
+                pending.push_back(std::move(child));
+            }
+        }
+        return entries;
+    }
+
+    // Database used by Hard; loaded once at startup, read-only afterwards
+    inline OpeningBook& perfectPlayBook() {
+        static OpeningBook book;
+        return book;
+    }
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "GameState.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Distance maps by mask dilation: how many queen (or king) moves each side needs to reach every
+// empty square. Whole BFS layers are computed at once by sliding all frontier squares along all 8
+// directions over a bit mask of the empty squares, instead of square by square.
+namespace distance {
+
+    inline constexpr int kMaxDimension = 10;
+    inline constexpr int kMaxSquares = kMaxDimension * kMaxDimension;
+    inline constexpr std::uint8_t kUnreached = 0xFF;
+
+    // A queen step slides over any number of empty squares in one of the 8 directions, a king step
+    // goes to one adjacent empty square
+    enum class Metric : std::uint8_t { Queen, King };
+
+    // Per-square distances in row-major order; occupied and unreachable squares hold kUnreached
+    using Map = std::array<std::uint8_t, kMaxSquares>;
+
+    struct SideMaps {
+        Map white;
+        Map black;
+
+        [[nodiscard]] const Map& of(Player player) const { return player == Player::White ? white : black; }
+    };
+
+    // Set of squares in a padded layout: row r, column c is bit r * (dim + 1) + c. Column 'dim' of
+    // every row is a guard that is never empty, so a one-column shift can't wrap into the next row.
+    // 10x10 takes 110 of the 128 bits.
+    struct Bitboard {
+        std::uint64_t low = 0;
+        std::uint64_t high = 0;
+
+        [[nodiscard]] bool any() const { return (low | high) != 0; }
+
+        [[nodiscard]] Bitboard operator|(const Bitboard& other) const { return { low | other.low, high | other.high }; }
+        [[nodiscard]] Bitboard operator&(const Bitboard& other) const { return { low & other.low, high & other.high }; }
+        [[nodiscard]] Bitboard operator~() const { return { ~low, ~high }; }
+        Bitboard& operator|=(const Bitboard& other) { low |= other.low; high |= other.high; return *this; }
+        Bitboard& operator&=(const Bitboard& other) { low &= other.low; high &= other.high; return *this; }
+
+        // Moves every bit 'amount' places up (towards higher squares), or down if negative
+        [[nodiscard]] Bitboard shifted(int amount) const {
+            if (amount >= 64) {
+                return { 0, low << (amount - 64) };
+            }
+            if (amount > 0) {
+                return { low << amount, (high << amount) | (low >> (64 - amount)) };
+            }
+            if (amount <= -64) {
+                return { high >> (-amount - 64), 0 };
+            }
+            if (amount < 0) {
+                return { (low >> -amount) | (high << (64 + amount)), high >> -amount };
+            }
+            return *this;
+        }
+
+        [[nodiscard]] bool test(int bit) const { return ((bit < 64 ? low >> bit : high >> (bit - 64)) & 1) != 0; }
+
+        void set(int bit) {
+            if (bit < 64) {
+                low |= std::uint64_t{ 1 } << bit;
+            }
+            else {
+                high |= std::uint64_t{ 1 } << (bit - 64);
+            }
+        }
+    };
+
+    inline int lowestBit(std::uint64_t word) {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanForward64(&index, word);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+    // Calls visit(bit) for every set bit, lowest first
+    template <typename Visit>
+    void forEachBit(const Bitboard& bits, Visit visit) {
+        for (std::uint64_t word = bits.low; word; word &= word - 1) {
+            visit(lowestBit(word));
+        }
+        for (std::uint64_t word = bits.high; word; word &= word - 1) {
+            visit(64 + lowestBit(word));
+        }
+    }
+
+    // Board split into the masks the kernels work on
+    struct Occupancy {
+        int dim = 0;
+        Bitboard empty;
+        Bitboard white;
+        Bitboard black;
+
+        Occupancy(const std::vector<TileContent>& tiles, int dimension)
+            : dim(dimension)
+        {
+            for (int square = 0; square < dim * dim; ++square) {
+                int bit = bitOf(square);
+                switch (tiles[static_cast<std::size_t>(square)]) {
+                case TileContent::Empty: empty.set(bit); break;
+                case TileContent::WhiteQueen: white.set(bit); break;
+                case TileContent::BlackQueen: black.set(bit); break;
+                default: break;
+                }
+            }
+        }
+
+        [[nodiscard]] int stride() const { return dim + 1; }
+        [[nodiscard]] int bitOf(int square) const { return square / dim * stride() + square % dim; }
+        [[nodiscard]] int squareOf(int bit) const { return bit / stride() * dim + bit % stride(); }
+        [[nodiscard]] const Bitboard& queens(Player player) const { return player == Player::White ? white : black; }
+    };
+
+    // Bit offsets of one step in each of the 8 directions
+    inline std::array<int, 8> directionSteps(int stride) {
+        return { 1, -1, stride, -stride, stride + 1, stride - 1, -stride + 1, -stride - 1 };
+    }
+
+    // Empty squares a queen on any square of 'from' reaches in one move along direction 'step':
+    // a Kogge-Stone fill through 'empty' that covers up to 15 squares, enough for 10x10
+    inline Bitboard slide(Bitboard from, Bitboard empty, int step) {
+        from |= empty & from.shifted(step);
+        empty &= empty.shifted(step);
+        from |= empty & from.shifted(2 * step);
+        empty &= empty.shifted(2 * step);
+        from |= empty & from.shifted(4 * step);
+        empty &= empty.shifted(4 * step);
+        from |= empty & from.shifted(8 * step);
+        return from;
+    }
+
+    // Empty squares one step of 'metric' away from any square of 'from'
+    inline Bitboard dilate(const Bitboard& from, const Occupancy& occupancy, Metric metric) {
+        Bitboard reached;
+        for (int step : directionSteps(occupancy.stride())) {
+            Bitboard target = metric == Metric::Queen ? slide(from, occupancy.empty, step) : from;
+            reached |= target.shifted(step);
+        }
+        return reached & occupancy.empty;
+    }
+
+    // Multi-source BFS from all of 'sources', one dilation per layer
+    inline void fill(const Bitboard& sources, const Occupancy& occupancy, Metric metric, Map& distances) {
+        distances.fill(kUnreached);
+        Bitboard reached = sources;
+        Bitboard frontier = sources;
+        for (std::uint8_t steps = 1; frontier.any(); ++steps) {
+            frontier = dilate(frontier, occupancy, metric) & ~reached;
+            reached |= frontier;
+            forEachBit(frontier, [&](int bit) { distances[static_cast<std::size_t>(occupancy.squareOf(bit))] = steps; });
+        }
+    }
+
+    inline void fill(const Occupancy& occupancy, Metric metric, SideMaps& maps) {
+        fill(occupancy.white, occupancy, metric, maps.white);
+        fill(occupancy.black, occupancy, metric, maps.black);
+    }
+
+    // Squares connected to 'seed' by king steps through squares that are in 'open', e.g. the region
+    // of a queen with 'open' the non-arrow squares
+    inline Bitboard connected(const Bitboard& seed, const Bitboard& open, int dim) {
+        Bitboard area = seed;
+        std::array<int, 8> steps = directionSteps(dim + 1);
+        for (Bitboard grown = area; ; area = grown) {
+            for (int step : steps) {
+                grown |= area.shifted(step) & open;
+            }
+            if (grown.low == area.low && grown.high == area.high) {
+                return area;
+            }
+        }
+    }
+
+    // Whole-number sums detail::territoryScore and the batch kernel collect from the distance maps,
+    // from one side's view. Both hand them to score(), so the two round the same total whatever
+    // order they add squares in. Closeness 2^-steps is fixed point with kClosenessOne for 1.
+    struct TerritorySums {
+        static constexpr int kClosenessBits = 32;
+        static constexpr std::int64_t kClosenessOne = std::int64_t{ 1 } << kClosenessBits;
+        static constexpr int kKingDistanceCap = 6;
+
+        int empty = 0;
+        int queenOwned = 0;               // squares reached first minus squares the opponent reaches first
+        int queenTied = 0;                // squares both reach equally fast
+        int kingOwned = 0;
+        int kingTied = 0;
+        int kingLead = 0;                 // king distance leads capped at kKingDistanceCap either way
+        std::int64_t queenCloseness = 0;  // own minus opponent's closeness
+        std::int64_t contact = 0;         // 2^-|distance difference| where both reach
+
+        // Closeness of a square 'steps' away; 0 past kClosenessBits or unreached
+        static constexpr std::int64_t closeness(int steps) { return steps >= kClosenessBits ? 0 : kClosenessOne >> steps; }
+
+        // A tied square leans a fifth towards the side to move, 'toMove' if that is this side
+        [[nodiscard]] int score(bool toMove) const {
+            if (empty == 0) {
+                return 0;
+            }
+            double tie = toMove ? 0.2 : -0.2;
+            double queenTerritory = queenOwned + tie * queenTied;
+            double kingTerritory = kingOwned + tie * kingTied;
+            double closenessLead = 2.0 * std::ldexp(static_cast<double>(queenCloseness), -kClosenessBits);
+            double kingCloseness = kingLead / static_cast<double>(kKingDistanceCap);
+
+            // Game phase: 1 with every square contested at equal distance, 0 once no square is shared
+            double phase = std::ldexp(static_cast<double>(contact), -kClosenessBits) / empty;
+            double opening = 0.3 * queenTerritory + 0.3 * kingTerritory + 0.2 * closenessLead + 0.2 * kingCloseness;
+            return static_cast<int>(std::lround((1.0 - phase) * queenTerritory + phase * opening));
+        }
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Fixed-size cache of static evaluations in front of evaluate, shared lock-free by all search
+// threads like the transposition table: one always-replace slot per index, stored as
+// (key ^ data, data) so a torn read fails the key check. Callers fold whatever the score depends
+// on besides the position (difficulty, perspective convention) into the key. Probes and hits are
+// counted for tuning the size.
+class EvalCache {
+public:
+    struct Stats {
+        std::uint64_t probes = 0;
+        std::uint64_t hits = 0;
+
+        [[nodiscard]] double hitRate() const { return probes ? static_cast<double>(hits) / static_cast<double>(probes) : 0.0; }
+    };
+
+    explicit EvalCache(std::size_t megabytes = 4) {
+        std::size_t slots = 1;
+        while (slots * 2 * sizeof(Slot) <= megabytes * 1024 * 1024) {
+            slots *= 2;
+        }
+        _slots = std::make_unique<Slot[]>(slots);
+        _mask = slots - 1;
+    }
+
+    bool probe(std::uint64_t key, int& score) const {
+        const auto& slot = _slots[key & _mask];
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+        _probes.fetch_add(1, std::memory_order_relaxed);
+        if (data == 0 || (check ^ data) != key) {
+            return false;
+        }
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data & 0xFFFFFFFFull));
+        return true;
+    }
+
+    void store(std::uint64_t key, int score) {
+        auto& slot = _slots[key & _mask];
+        std::uint64_t data = static_cast<std::uint32_t>(score) | kOccupied;
+        slot.check.store(key ^ data, std::memory_order_relaxed);
+        slot.data.store(data, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] Stats stats() const {
+        return { _probes.load(std::memory_order_relaxed), _hits.load(std::memory_order_relaxed) };
+    }
+
+    void resetStats() {
+        _probes.store(0, std::memory_order_relaxed);
+        _hits.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> check{ 0 };
+        std::atomic<std::uint64_t> data{ 0 };
+    };
+
+    static constexpr std::uint64_t kOccupied = std::uint64_t{ 1 } << 32;  // tells a stored 0 from an empty slot
+
+    std::unique_ptr<Slot[]> _slots;
+    std::size_t _mask = 0;
+    // Own cache lines, so counting doesn't contend with the slots
+    alignas(64) mutable std::atomic<std::uint64_t> _probes{ 0 };
+    alignas(64) mutable std::atomic<std::uint64_t> _hits{ 0 };
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+// Weights of the hand-written evaluation terms, in sixteenths so tuned values needn't be whole
+// numbers, one set per evaluation profile below: a profile that leaves a term out needs the others
+// weighted differently. The defaults are the hand-picked 3 / 1 / 5; tools/EvalTune.cpp fits new
+// ones to game outcomes and writes them in the format load() reads.
+struct EvalWeights {
+    static constexpr int kScale = 16;
+    static constexpr std::size_t kProfiles = 3;
+
+    struct Terms {
+        int mobility = 3 * kScale;
+        int spatial = 1 * kScale;
+        int territory = 5 * kScale;
+    };
+
+    std::array<Terms, kProfiles> profiles{};  // by Profile::kId
+
+    // Weights used by evaluate(); loaded once at startup, read-only afterwards
+    static EvalWeights& instance() {
+        static EvalWeights weights;
+        return weights;
+    }
+
+    template <typename Profile>
+    [[nodiscard]] const Terms& of(Profile) const { return profiles[Profile::kId]; }
+
+    // Keeps the current weights if the file can't be read, doesn't match or has a weight that
+    // isn't positive
+    bool load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        FileHeader header{};
+        std::int32_t values[kProfiles][kTerms]{};
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, kFileMagic, sizeof(header.magic)) != 0 || header.version != kFileVersion
+            || header.profiles != kProfiles || header.terms != kTerms || header.scale != kScale
+            || !in.read(reinterpret_cast<char*>(values), sizeof(values))) {
+            return false;
+        }
+        for (const auto& profile : values) {
+            if (std::any_of(std::begin(profile), std::end(profile), [](std::int32_t value) { return value <= 0; })) {
+                return false;
+            }
+        }
+        for (std::size_t profile = 0; profile < kProfiles; ++profile) {
+            profiles[profile] = Terms{ values[profile][0], values[profile][1], values[profile][2] };
+        }
+        return true;
+    }
+
+    bool write(const std::string& path) const {
+        FileHeader header{};
+        std::memcpy(header.magic, kFileMagic, sizeof(header.magic));
+        header.version = kFileVersion;
+        header.profiles = kProfiles;
+        header.terms = kTerms;
+        header.scale = kScale;
+        std::int32_t values[kProfiles][kTerms]{};
+        for (std::size_t profile = 0; profile < kProfiles; ++profile) {
+            values[profile][0] = profiles[profile].mobility;
+            values[profile][1] = profiles[profile].spatial;
+            values[profile][2] = profiles[profile].territory;
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(values), sizeof(values));
+        return static_cast<bool>(out);
+    }
+
+private:
+    static constexpr std::uint32_t kTerms = 3;
+
+    struct FileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t profiles;
+        std::uint32_t terms;
+        std::uint32_t scale;
+    };
+
+    static constexpr char kFileMagic[8] = { 'A', 'M', 'Z', 'E', 'V', 'A', 'L', 'W' };
+    static constexpr std::uint32_t kFileVersion = 2;
+};
+
+// Evaluation profiles: which of the terms above evaluate() adds up, as types. A search runs
+// specialised for one profile, so terms a profile leaves out aren't even compiled into it.
+// 'kId' tells profiles apart in cache keys.
+struct EasyProfile {
+    static constexpr std::uint64_t kId = 0;
+    static constexpr bool kSpatial = false;
+    static constexpr bool kTerritory = false;
+};
+
+struct MediumProfile {
+    static constexpr std::uint64_t kId = 1;
+    static constexpr bool kSpatial = true;
+    static constexpr bool kTerritory = false;
+};
+
+struct HardProfile {
+    static constexpr std::uint64_t kId = 2;
+    static constexpr bool kSpatial = true;
+    static constexpr bool kTerritory = true;
+};
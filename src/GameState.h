@@ -45,6 +45,11 @@ struct Move {
     Position queenFrom;
     Position queenTo;
     Position arrow;
+
+    bool operator==(const Move& other) const {
+        return player == other.player && queenFrom == other.queenFrom && queenTo == other.queenTo && arrow == other.arrow;
+    }
+    bool operator!=(const Move& other) const { return !(*this == other); }
 };
 
 struct BoardLayout {
@@ -124,6 +129,16 @@ public:
         _board.setTile(pos.row, pos.col, TileContent::Arrow);
     }
 
+    // Takes back the most recent arrow (search make/unmake is strictly LIFO)
+    void removeLastArrow() {
+        if (_arrows.empty()) {
+            throw std::runtime_error("No arrow to remove");
+        }
+        const auto& pos = _arrows.back();
+        _board.setTile(pos.row, pos.col, TileContent::Empty);
+        _arrows.pop_back();
+    }
+
     void updateQueenPosition(Player player, const Position& from, const Position& to) {
         auto& positions = _queens[playerIndex(player)];
         auto it = std::find(positions.begin(), positions.end(), from);
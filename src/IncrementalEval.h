@@ -0,0 +1,150 @@
+#pragma once
+
+#include "Board.h"
+#include "GameState.h"
+
+#include <array>
+#include <cstdint>
+
+namespace detail {
+
+    // Centralities are fixed point with kCentralityOne for 1; every (dim - 1) divides it, so the
+    // tables are exact
+    inline constexpr int kCentralityOne = 1260;
+
+    using CentralityTable = std::array<std::int16_t, 100>;
+
+    // Indexed by board dimension; only 6, 8 and 10 are filled. Twice the distance from the centre
+    // is a whole number on any board.
+    constexpr std::array<CentralityTable, 11> makeCentralityTables() {
+        std::array<CentralityTable, 11> tables{};
+        for (int dim = 6; dim <= 10; dim += 2) {
+            for (int square = 0; square < dim * dim; ++square) {
+                int row = 2 * (square / dim) - (dim - 1);
+                int col = 2 * (square % dim) - (dim - 1);
+                int twiceDist = (row < 0 ? -row : row) + (col < 0 ? -col : col);
+                tables[static_cast<std::size_t>(dim)][static_cast<std::size_t>(square)] =
+                    static_cast<std::int16_t>(kCentralityOne - kCentralityOne / 4 * twiceDist / (dim - 1));
+            }
+        }
+        return tables;
+    }
+
+    inline constexpr std::array<CentralityTable, 11> kCentralityTables = makeCentralityTables();
+}
+
+// Evaluation terms that SearchPosition keeps up to date on make/unmake, one tile change at a time:
+// how many queens of each side reach every square in one queen move, each side's total of such
+// targets (its queens' mobility) and the sum of its queens' centralities. A tile change only
+// matters to the queens on the four lines through it, so an update walks those lines instead of
+// rescanning the board.
+class IncrementalEval {
+public:
+    static constexpr int kCentralityOne = detail::kCentralityOne;
+
+    // kCentralityOne in the centre of the board down to half of it in the corners (Manhattan
+    // distance from the centre), from a table built at compile time
+    static constexpr int centrality(int dim, int square) {
+        return detail::kCentralityTables[static_cast<std::size_t>(dim)][static_cast<std::size_t>(square)];
+    }
+
+    explicit IncrementalEval(const Board& board)
+        : _dim(board.dimension())
+    {
+        _cells.fill(TileContent::Arrow);
+        for (int square = 0; square < _dim * _dim; ++square) {
+            set(square, board.tiles()[static_cast<std::size_t>(square)]);
+        }
+    }
+
+    // The tile on 'square' becomes 'tile'
+    void set(int square, TileContent tile) {
+        int cell = cellOf(square);
+        TileContent before = _cells[static_cast<std::size_t>(cell)];
+        if (before == tile) {
+            return;
+        }
+        if (isQueen(before)) {
+            addQueen(square, cell, before, -1);
+        }
+        _cells[static_cast<std::size_t>(cell)] = tile;
+        if ((before == TileContent::Empty) != (tile == TileContent::Empty)) {
+            updateLinesThrough(cell, tile == TileContent::Empty ? 1 : -1);
+        }
+        if (isQueen(tile)) {
+            addQueen(square, cell, tile, 1);
+        }
+    }
+
+    // Number of 'player's queens that reach 'square' in one move
+    [[nodiscard]] int reachers(Player player, int square) const { return _reach[side(player)][static_cast<std::size_t>(cellOf(square))]; }
+    [[nodiscard]] int mobility(Player player) const { return _mobility[side(player)]; }
+    // Sum of the centralities of 'player's queens, fixed point
+    [[nodiscard]] int centrality(Player player) const { return _centrality[side(player)]; }
+
+private:
+    // The board inside a border of arrows, so walks need no bounds checks
+    static constexpr int kStride = 12;
+    static constexpr int kCells = kStride * kStride;
+    static constexpr std::array<int, 4> kLines = { 1, kStride, kStride + 1, kStride - 1 };
+
+    std::array<TileContent, kCells> _cells{};
+    int _dim = 0;
+    std::array<std::array<std::uint8_t, kCells>, 2> _reach{};
+    std::array<int, 2> _mobility{};
+    std::array<int, 2> _centrality{};
+
+    static std::size_t side(Player player) { return player == Player::White ? 0 : 1; }
+    static std::size_t side(TileContent queen) { return queen == TileContent::WhiteQueen ? 0 : 1; }
+
+    [[nodiscard]] int cellOf(int square) const { return (square / _dim + 1) * kStride + square % _dim + 1; }
+    [[nodiscard]] bool isEmpty(int cell) const { return _cells[static_cast<std::size_t>(cell)] == TileContent::Empty; }
+
+    void bump(std::size_t owner, int cell, int delta) {
+        auto& count = _reach[owner][static_cast<std::size_t>(cell)];
+        count = static_cast<std::uint8_t>(count + delta);
+        _mobility[owner] += delta;
+    }
+
+    // First non-empty cell from 'cell' (exclusive) in steps of 'step'
+    [[nodiscard]] int blockerOf(int cell, int step) const {
+        do {
+            cell += step;
+        } while (isEmpty(cell));
+        return cell;
+    }
+
+    // Bumps the empty cells strictly between 'from' and 'to' along 'step'
+    void bumpRun(std::size_t owner, int from, int to, int step, int delta) {
+        for (int cell = from + step; cell != to; cell += step) {
+            bump(owner, cell, delta);
+        }
+    }
+
+    void addQueen(int square, int cell, TileContent queen, int delta) {
+        std::size_t owner = side(queen);
+        for (int step : kLines) {
+            bumpRun(owner, cell, blockerOf(cell, step), step, delta);
+            bumpRun(owner, cell, blockerOf(cell, -step), -step, delta);
+        }
+        _centrality[owner] += delta * centrality(_dim, square);
+    }
+
+    // 'cell' turned empty (delta 1) or stopped being empty (delta -1): a queen that sees it along
+    // a line now reaches, or no longer reaches, it and the run of empty cells behind it. The runs
+    // start at 'cell' itself, one step back from where bumpRun begins.
+    void updateLinesThrough(int cell, int delta) {
+        for (int step : kLines) {
+            int front = blockerOf(cell, step);
+            int back = blockerOf(cell, -step);
+            if (isQueen(_cells[static_cast<std::size_t>(front)])) {
+                std::size_t owner = side(_cells[static_cast<std::size_t>(front)]);
+                bumpRun(owner, cell + step, back, -step, delta);
+            }
+            if (isQueen(_cells[static_cast<std::size_t>(back)])) {
+                std::size_t owner = side(_cells[static_cast<std::size_t>(back)]);
+                bumpRun(owner, cell - step, front, step, delta);
+            }
+        }
+    }
+};
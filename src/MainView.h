@@ -2,6 +2,7 @@
 
 #include "AmazonsBoardCanvas.h"
 #include "Algorithms.h"
+#include "SearchSession.h"
 #include "SettingsPopup.h"
 #include "DialogSettings.h"
 #include "RulesView.h"
@@ -105,15 +106,21 @@ private:
     std::thread _aiThread;
     bool _aiThinking = false;
     std::atomic_bool _cancelAi{ false };
+    std::atomic_bool _stopPonder{ false };
+    bool _pondering = false;  // _aiThread is pondering rather than searching
+    SearchSession _searchSession;  // used by the AI thread only, one search or ponder at a time
     std::function<void(bool, bool)> _toolbarStateHandler;
     std::function<void(const td::String&)> _statusBarHandler;
 
     void populateControls();
     void wireCallbacks();
+    void loadEngineData();
     void startNewGame();
     void handleHumanMove(const Move& move);
     void handleAiMove(const Move& move);
     void requestAiMove();
+    void startPondering();
+    std::thread stopPondering();
     void updateStatusForPhase(AmazonsBoardCanvas::SelectionPhase phase);
     void setStatusText(const td::String& text);
     void updateControlsState();
@@ -187,6 +194,7 @@ inline MainView::MainView()
 
     populateControls();
     wireCallbacks();
+    loadEngineData();
     setLayout(&_layout);
     startNewGame();
     updateLogsView(); // Initialize logs view with empty state
@@ -196,6 +204,33 @@ inline MainView::~MainView() {
     finalizeAiThread();
 }
 
+inline void MainView::loadEngineData() {
+    // Generated offline (tools/); without them the engine solves small regions by search and
+    // plays openings from its own search
+    td::String fn = gui::getResFileName("region-db");
+    if (fn.c_str() && fn.c_str()[0] != '\0') {
+        regions::RegionDatabase::instance().load(fn.c_str());
+    }
+    fn = gui::getResFileName("opening-book");
+    if (fn.c_str() && fn.c_str()[0] != '\0') {
+        OpeningBook::instance().load(fn.c_str());
+    }
+    fn = gui::getResFileName("solved-6x6");
+    if (fn.c_str() && fn.c_str()[0] != '\0') {
+        proof::perfectPlayBook().load(fn.c_str());
+    }
+    // Tuned weights of the hand-written evaluation (tools/EvalTune); defaults without them
+    fn = gui::getResFileName("eval-weights");
+    if (fn.c_str() && fn.c_str()[0] != '\0') {
+        EvalWeights::instance().load(fn.c_str());
+    }
+    // Trained evaluation network; without it alpha-beta uses the hand-written evaluation
+    fn = gui::getResFileName("eval-net");
+    if (fn.c_str() && fn.c_str()[0] != '\0') {
+        nnue::Network::instance().load(fn.c_str());
+    }
+}
+
 inline void MainView::focusBoard() {
     _boardCanvas.setFocus(true);
 }
@@ -312,6 +347,7 @@ inline void MainView::startNewGame() {
     finalizeAiThread();
     _aiThinking = false;
     _cancelAi.store(false);
+    _searchSession.reset();
 
     _state.startNewGame(selectedBoardDimension(), selectedDifficulty());
     _gameOverDialogShown = false;
@@ -326,6 +362,9 @@ inline void MainView::startNewGame() {
         _boardCanvas.setInteractionEnabled(false);
         requestAiMove();
     }
+    else {
+        startPondering();
+    }
 }
 
 inline void MainView::openSettingsDialog()
@@ -424,6 +463,7 @@ inline void MainView::handleHumanMove(const Move& move) {
     tryHandleGameEnd();
 
     if (_state.isFinished()) {
+        finalizeAiThread();  // stops pondering
         return;
     }
 
@@ -474,12 +514,50 @@ inline void MainView::handleAiMove(const Move& move) {
     if (!isCurrentPlayerAI()) {
         _boardCanvas.setInteractionEnabled(true);
         updateStatusForPhase(_boardCanvas.currentPhase());
+        startPondering();
     }
     else {
         requestAiMove();
     }
 }
 
+// Runs SearchSession::ponder on the AI thread while the human thinks about a move against the AI;
+// the interface stays enabled. requestAiMove stops it through stopPondering, everything else
+// through finalizeAiThread.
+inline void MainView::startPondering() {
+    Player human = _state.currentPlayer();
+    PlayerType opponentType = human == Player::White ? _blackPlayerType : _whitePlayerType;
+    auto difficulty = _state.difficulty();
+    SearchLimits limits = searchLimitsForDifficulty(difficulty);
+    if (_state.isFinished() || isCurrentPlayerAI() || opponentType != PlayerType::AI || !limits.ponder) {
+        return;
+    }
+
+    finalizeAiThread();
+    _stopPonder.store(false);
+    _pondering = true;
+    GameState snapshot = _state.clone();
+    _aiThread = std::thread([this, snapshot, limits, difficulty]() {
+        try {
+            _searchSession.ponder(snapshot, limits, difficulty, _stopPonder);
+        }
+        catch (...) {
+            // Pondering is best effort; the real search reports its own errors
+        }
+    });
+}
+
+// Tells the ponder thread to stop and hands it over without waiting for it; the search thread
+// joins it before touching the session, so the interface never waits for pondering to end
+inline std::thread MainView::stopPondering() {
+    if (!_pondering) {
+        return {};
+    }
+    _pondering = false;
+    _stopPonder.store(true);
+    return std::move(_aiThread);
+}
+
 inline void MainView::requestAiMove() {
     if (_aiThinking || _state.isFinished() || !isCurrentPlayerAI()) {
         return;
@@ -497,16 +575,20 @@ inline void MainView::requestAiMove() {
     bool useDelay = (_whitePlayerType == PlayerType::AI && _blackPlayerType == PlayerType::AI);
     int delayMs = _aiDelayMS;
 
+    std::thread ponderThread = stopPondering();
     finalizeAiThread();
     // reset cancellation token for this search
     _cancelAi.store(false);
     
-    _aiThread = std::thread([this, snapshot, difficulty, useDelay, delayMs]() mutable {
+    _aiThread = std::thread([this, snapshot, difficulty, useDelay, delayMs, ponderThread = std::move(ponderThread)]() mutable {
         try {
+            if (ponderThread.joinable()) {
+                ponderThread.join();
+            }
             // Check before heavy work
             if (_cancelAi.load()) throw SearchCanceled();
             
-            Move bestMove = getBestMove(snapshot, difficulty, &_cancelAi);
+            Move bestMove = _searchSession.bestMove(snapshot, difficulty, &_cancelAi);
             
             // IMPORTANT FIX: Broken-up sleep to allow instant cancellation
             if (useDelay) {
@@ -659,8 +741,11 @@ inline Difficulty MainView::selectedDifficulty() const {
 }
 
 inline void MainView::finalizeAiThread() {
-    // Signal cancellation and wait for any running AI thread to finish.
+    // Signal cancellation and wait for any running AI thread to finish. Searches and pondering
+    // poll their flags, so this takes tens of milliseconds at most.
     _cancelAi.store(true);
+    _stopPonder.store(true);
+    _pondering = false;
     if (_aiThread.joinable()) {
         _aiThread.join();
     }
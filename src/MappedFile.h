@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file, released with the object
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps 'path' (UTF-8); returns false if it can't be opened or is empty
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+        if (length <= 0) {
+            return false;
+        }
+        std::wstring widePath(static_cast<std::size_t>(length), L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, widePath.data(), length);
+
+        _file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(_file, &fileSize) || fileSize.QuadPart == 0) {
+            close();
+            return false;
+        }
+        _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_mapping) {
+            close();
+            return false;
+        }
+        _data = static_cast<const unsigned char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!_data) {
+            close();
+            return false;
+        }
+        _size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // the mapping keeps the file alive
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        _data = static_cast<const unsigned char*>(mapped);
+        _size = static_cast<std::size_t>(info.st_size);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (_data) {
+            UnmapViewOfFile(_data);
+        }
+        if (_mapping) {
+            CloseHandle(_mapping);
+        }
+        if (_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(_file);
+        }
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_data) {
+            munmap(const_cast<unsigned char*>(_data), _size);
+        }
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    [[nodiscard]] bool isOpen() const { return _data != nullptr; }
+    [[nodiscard]] const unsigned char* data() const { return _data; }
+    [[nodiscard]] std::size_t size() const { return _size; }
+
+private:
+    const unsigned char* _data = nullptr;
+    std::size_t _size = 0;
+#ifdef _WIN32
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#endif
+};
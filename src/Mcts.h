@@ -0,0 +1,507 @@
+#pragma once
+
+#include "Algorithms.h"
+#include "SearchPosition.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Monte Carlo tree search (UCT) engine. All search threads share one tree (tree parallelism);
+// a thread descending through a node adds a virtual loss to it so the others spread out over
+// different lines until the real result is backed up.
+namespace mcts {
+
+    inline constexpr std::uint32_t kNoNode = std::numeric_limits<std::uint32_t>::max();
+    inline constexpr std::int64_t kRewardScale = 1024;  // results in [0, 1] are summed in fixed point
+    inline constexpr int kMaxPathLength = 128;          // longer than any game on a 10x10 board
+    inline constexpr int kMaxRayTargets = 36;           // a queen reaches at most 35 squares on 10x10
+    inline constexpr int kMaxQueens = 4;
+    inline constexpr std::uint32_t kWideningBase = 2;   // children tried before sqrt(visits) lets more in
+    inline constexpr double kReachScale = 6.0;          // reach balance that maps to a ~73% win chance
+    inline constexpr std::size_t kMinArenaNodes = 1 << 16;  // always room for the root and all its moves
+
+    enum class Expansion : std::uint8_t {
+        Leaf = 0,
+        Expanding,
+        Expanded
+    };
+
+    // Node for the move that led to it. Statistics are updated lock-free by every search thread;
+    // the child block and the moves in it are written once by the expanding thread before it
+    // publishes Expanded.
+    struct Node {
+        std::atomic<std::uint32_t> visits{ 0 };
+        std::atomic<std::int32_t> virtualLoss{ 0 };
+        std::atomic<std::int64_t> reward{ 0 };  // for the player who made the move, kRewardScale units
+        std::atomic<Expansion> expansion{ Expansion::Leaf };
+        std::uint32_t firstChild = kNoNode;
+        std::uint16_t childCount = 0;
+        std::uint8_t from = 0;
+        std::uint8_t to = 0;
+        std::uint8_t arrow = 0;
+    };
+
+    // Fixed pool of nodes, handed out as contiguous child blocks by an atomic bump pointer
+    class NodeArena {
+    public:
+        explicit NodeArena(std::size_t megabytes)
+            : _capacity(std::clamp<std::size_t>(megabytes * 1024 * 1024 / sizeof(Node), kMinArenaNodes, kNoNode - 1))
+            , _nodes(std::make_unique<Node[]>(_capacity))
+        {
+        }
+
+        // First of 'count' consecutive fresh nodes, or kNoNode once the arena is exhausted
+        std::uint32_t allocate(std::size_t count) {
+            std::size_t first = _used.fetch_add(count, std::memory_order_relaxed);
+            if (first + count > _capacity) {
+                return kNoNode;
+            }
+            return static_cast<std::uint32_t>(first);
+        }
+
+        Node& operator[](std::uint32_t idx) { return _nodes[idx]; }
+        const Node& operator[](std::uint32_t idx) const { return _nodes[idx]; }
+
+    private:
+        std::size_t _capacity;
+        std::unique_ptr<Node[]> _nodes;
+        std::atomic<std::size_t> _used{ 0 };
+    };
+
+    // xorshift64*, cheap enough for every playout move
+    class Rng {
+    public:
+        explicit Rng(std::uint64_t seed)
+            : _state(seed ? seed : 0x9E3779B97F4A7C15ull)
+        {
+        }
+
+        // Uniform in [0, bound)
+        std::uint32_t below(std::uint32_t bound) {
+            return static_cast<std::uint32_t>(((next() >> 32) * bound) >> 32);
+        }
+
+    private:
+        std::uint64_t _state;
+
+        std::uint64_t next() {
+            _state ^= _state >> 12;
+            _state ^= _state << 25;
+            _state ^= _state >> 27;
+            return _state * 0x2545F4914F6CDD1Dull;
+        }
+    };
+
+    // Uniformly random queen step followed by a uniformly random arrow, without allocating.
+    // Returns false when the side to move has no legal move, i.e. has lost.
+    inline bool randomMove(const SearchPosition& position, Rng& rng, Move& move) {
+        const auto& tiles = position.board().tiles();
+        int dim = position.dimension();
+        Player player = position.currentPlayer();
+
+        std::array<std::uint8_t, kMaxQueens * kMaxRayTargets> stepFrom;
+        std::array<std::uint8_t, kMaxQueens * kMaxRayTargets> stepTo;
+        std::uint32_t stepCount = 0;
+        for (const auto& queen : position.state().queenPositions(player)) {
+            int from = position.squareIndex(queen);
+            forEachReachableSquare(tiles, dim, from, -1, [&](int target) {
+                stepFrom[stepCount] = static_cast<std::uint8_t>(from);
+                stepTo[stepCount++] = static_cast<std::uint8_t>(target);
+            });
+        }
+        if (stepCount == 0) {
+            return false;
+        }
+
+        std::uint32_t step = rng.below(stepCount);
+        int from = stepFrom[step];
+        int to = stepTo[step];
+
+        // The square just left is always a target, so there is at least one arrow
+        std::array<std::uint8_t, kMaxRayTargets> arrows;
+        std::uint32_t arrowCount = 0;
+        forEachReachableSquare(tiles, dim, to, from, [&](int target) {
+            arrows[arrowCount++] = static_cast<std::uint8_t>(target);
+        });
+
+        move = { player, position.positionOf(from), position.positionOf(to), position.positionOf(arrows[rng.below(arrowCount)]) };
+        return true;
+    }
+
+    // Static playout result for 'player': squares only its queens reach in one move against squares
+    // only the opponent's reach, squashed into a win probability.
+    inline double reachScore(const SearchPosition& position, Player player) {
+        const auto& tiles = position.board().tiles();
+        int dim = position.dimension();
+        std::array<std::uint8_t, zobrist::kMaxSquares> reach{};
+        for (Player side : { player, opponentOf(player) }) {
+            std::uint8_t mark = side == player ? 1 : 2;
+            for (const auto& queen : position.state().queenPositions(side)) {
+                forEachReachableSquare(tiles, dim, position.squareIndex(queen), -1, [&](int target) {
+                    reach[static_cast<std::size_t>(target)] |= mark;
+                });
+            }
+        }
+
+        int balance = 0;
+        for (auto mark : reach) {
+            balance += (mark == 1) - (mark == 2);
+        }
+        return 1.0 / (1.0 + std::exp(-balance / kReachScale));
+    }
+
+    // Plays up to 'turns' random turns, scores the outcome for 'player' and takes the turns back
+    inline double playout(SearchPosition& position, Player player, int turns, Rng& rng) {
+        std::array<Move, kMaxPathLength> played;
+        int count = 0;
+        int limit = std::clamp(turns, 0, kMaxPathLength);
+        double result = -1.0;
+        while (count < limit) {
+            if (!randomMove(position, rng, played[static_cast<std::size_t>(count)])) {
+                result = position.currentPlayer() == player ? 0.0 : 1.0;
+                break;
+            }
+            position.makeMove(played[static_cast<std::size_t>(count++)]);
+        }
+        if (result < 0.0) {
+            result = reachScore(position, player);
+        }
+        while (count > 0) {
+            position.unmakeMove(played[static_cast<std::size_t>(--count)]);
+        }
+        return result;
+    }
+
+    // Tree shared by the search threads of one getBestMoveMcts call
+    class SearchTree {
+    public:
+        SearchTree(const GameState& rootState, const SearchLimits& limits)
+            : _rootState(rootState)
+            , _limits(limits)
+            , _arena(limits.treeMegabytes)
+            , _root(_arena.allocate(1))
+        {
+            SearchPosition position(_rootState);
+            expand(_root, position, true);
+        }
+
+        // Tree for 'rootState' that keeps what 'previous' learned about it, if the position is the
+        // previous root or one or two plies below it. The subtree is copied into a fresh arena.
+        SearchTree(const SearchTree& previous, const GameState& rootState, const SearchLimits& limits)
+            : SearchTree(rootState, limits)
+        {
+            std::uint32_t match = previous.findDescendant(zobrist::hashOf(rootState));
+            if (match != kNoNode) {
+                adopt(previous, match);
+            }
+            _startVisits = _arena[_root].visits.load();
+        }
+
+        [[nodiscard]] std::size_t rootMoves() const { return _arena[_root].childCount; }
+
+        // True if a tree built from this one for 'state' would keep some of its statistics
+        [[nodiscard]] bool reaches(const GameState& state) const { return findDescendant(zobrist::hashOf(state)) != kNoNode; }
+
+        // Runs playouts until the deadline, cancellation, or another thread stopping the search
+        void search(std::size_t task, std::chrono::steady_clock::time_point deadline, const std::atomic_bool* cancel) {
+            SearchPosition position(_rootState, false);  // playouts are scored by reachScore, not evaluate
+            Rng rng(position.hash() ^ (0x9E3779B97F4A7C15ull * (task + 1)));
+            for (std::uint32_t iteration = 0; !_stop.load(std::memory_order_relaxed); ++iteration) {
+                if ((cancel && cancel->load(std::memory_order_relaxed))
+                    || ((iteration & 15) == 0 && std::chrono::steady_clock::now() >= deadline)
+                    || (task == 0 && (iteration & 255) == 255 && isDecided(deadline))) {
+                    _stop.store(true, std::memory_order_relaxed);
+                    break;
+                }
+                iterate(position, rng);
+            }
+        }
+
+        // Most visited root move (the most robust choice); empty Move if there is none
+        [[nodiscard]] Move bestMove() const {
+            const Node& root = _arena[_root];
+            if (root.childCount == 0) {
+                return {};
+            }
+            std::uint32_t best = root.firstChild;
+            for (std::uint32_t idx = root.firstChild + 1; idx < root.firstChild + root.childCount; ++idx) {
+                if (_arena[idx].visits.load() > _arena[best].visits.load()) {
+                    best = idx;
+                }
+            }
+            SearchPosition position(_rootState);
+            return moveOf(position, _arena[best], _rootState.currentPlayer());
+        }
+
+        struct RootChild {
+            Move move;
+            std::uint32_t visits;
+        };
+
+        // Root moves that were visited at all, most visited first
+        [[nodiscard]] std::vector<RootChild> rootChildren() const {
+            std::vector<RootChild> children;
+            const Node& root = _arena[_root];
+            SearchPosition position(_rootState);
+            for (std::uint32_t idx = root.firstChild; idx < root.firstChild + root.childCount; ++idx) {
+                std::uint32_t visits = _arena[idx].visits.load();
+                if (visits > 0) {
+                    children.push_back({ moveOf(position, _arena[idx], _rootState.currentPlayer()), visits });
+                }
+            }
+            std::stable_sort(children.begin(), children.end(), [](const RootChild& a, const RootChild& b) { return a.visits > b.visits; });
+            return children;
+        }
+
+    private:
+        GameState _rootState;
+        SearchLimits _limits;
+        NodeArena _arena;
+        std::uint32_t _root;
+        std::atomic_bool _stop{ false };
+        std::atomic_bool _arenaFull{ false };
+        std::chrono::steady_clock::time_point _started = std::chrono::steady_clock::now();
+        std::uint32_t _startVisits = 0;  // root visits carried over from an earlier tree
+
+        // True once the most visited root move can't be overtaken in the time left at the playout
+        // rate so far; a reused tree often starts out that way
+        bool isDecided(std::chrono::steady_clock::time_point deadline) const {
+            auto now = std::chrono::steady_clock::now();
+            std::uint32_t done = _arena[_root].visits.load(std::memory_order_relaxed) - _startVisits;
+            double elapsed = std::chrono::duration<double>(now - _started).count();
+            if (done == 0 || elapsed <= 0.0) {
+                return false;
+            }
+            double expected = done * std::chrono::duration<double>(deadline - now).count() / elapsed;
+
+            const Node& root = _arena[_root];
+            std::uint32_t best = 0;
+            std::uint32_t second = 0;
+            for (std::uint32_t idx = root.firstChild; idx < root.firstChild + root.childCount; ++idx) {
+                std::uint32_t visits = _arena[idx].visits.load(std::memory_order_relaxed);
+                if (visits > best) {
+                    second = best;
+                    best = visits;
+                }
+                else if (visits > second) {
+                    second = visits;
+                }
+            }
+            return best - second > expected;
+        }
+
+        // Node of the position with plain hash 'hash' among the root and the two plies below it
+        std::uint32_t findDescendant(std::uint64_t hash) const {
+            SearchPosition position(_rootState);
+            if (position.hash() == hash) {
+                return _root;
+            }
+            const Node& root = _arena[_root];
+            for (std::uint32_t idx = root.firstChild; idx < root.firstChild + root.childCount; ++idx) {
+                const Node& child = _arena[idx];
+                Move move = moveOf(position, child, position.currentPlayer());
+                if (position.hashAfter(move) == hash) {
+                    return idx;
+                }
+                if (child.expansion.load(std::memory_order_acquire) != Expansion::Expanded) {
+                    continue;
+                }
+                position.makeMove(move);
+                for (std::uint32_t reply = child.firstChild; reply < child.firstChild + child.childCount; ++reply) {
+                    if (position.hashAfter(moveOf(position, _arena[reply], position.currentPlayer())) == hash) {
+                        return reply;
+                    }
+                }
+                position.unmakeMove(move);
+            }
+            return kNoNode;
+        }
+
+        // Gives the (fully expanded) root the statistics of node 'match' of 'previous', and each root
+        // child the subtree of the matching child there. Copies level by level, so if the arena runs
+        // out only the deepest nodes are lost.
+        void adopt(const SearchTree& previous, std::uint32_t match) {
+            const Node& source = previous._arena[match];
+            Node& root = _arena[_root];
+            root.visits.store(source.visits.load());
+            root.reward.store(source.reward.load());
+            if (source.expansion.load(std::memory_order_acquire) != Expansion::Expanded) {
+                return;
+            }
+
+            auto moveKey = [](const Node& node) { return node.from | (node.to << 8) | (node.arrow << 16); };
+            std::unordered_map<int, std::uint32_t> sourceChildren;
+            for (std::uint32_t idx = source.firstChild; idx < source.firstChild + source.childCount; ++idx) {
+                sourceChildren.emplace(moveKey(previous._arena[idx]), idx);
+            }
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> pending;  // (source, target)
+            for (std::uint32_t idx = root.firstChild; idx < root.firstChild + root.childCount; ++idx) {
+                auto found = sourceChildren.find(moveKey(_arena[idx]));
+                if (found != sourceChildren.end()) {
+                    pending.emplace_back(found->second, idx);
+                }
+            }
+
+            for (std::size_t head = 0; head < pending.size(); ++head) {
+                const Node& from = previous._arena[pending[head].first];
+                Node& to = _arena[pending[head].second];
+                to.visits.store(from.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                to.reward.store(from.reward.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                if (from.expansion.load(std::memory_order_acquire) != Expansion::Expanded) {
+                    continue;
+                }
+                std::uint32_t first = from.childCount == 0 ? kNoNode : _arena.allocate(from.childCount);
+                if (from.childCount > 0 && first == kNoNode) {
+                    _arenaFull.store(true, std::memory_order_relaxed);
+                    continue;
+                }
+                for (std::uint32_t offset = 0; offset < from.childCount; ++offset) {
+                    const Node& fromChild = previous._arena[from.firstChild + offset];
+                    Node& toChild = _arena[first + offset];
+                    toChild.from = fromChild.from;
+                    toChild.to = fromChild.to;
+                    toChild.arrow = fromChild.arrow;
+                    pending.emplace_back(from.firstChild + offset, first + offset);
+                }
+                to.firstChild = first;
+                to.childCount = from.childCount;
+                to.expansion.store(Expansion::Expanded, std::memory_order_release);
+            }
+        }
+
+        static Move moveOf(const SearchPosition& position, const Node& node, Player player) {
+            return { player, position.positionOf(node.from), position.positionOf(node.to), position.positionOf(node.arrow) };
+        }
+
+        // Gives a leaf its children, best ordered first; the root keeps every legal move. Returns
+        // false if another thread is already expanding the node or the arena is exhausted.
+        bool expand(std::uint32_t nodeIdx, const SearchPosition& position, bool isRoot) {
+            Node& node = _arena[nodeIdx];
+            Expansion expected = Expansion::Leaf;
+            if (!node.expansion.compare_exchange_strong(expected, Expansion::Expanding)) {
+                return false;
+            }
+
+            std::size_t width = isRoot ? std::numeric_limits<std::size_t>::max() : _limits.treeChildren;
+            auto moves = detail::generateOrderedMoves(position, width, TableMove{});
+            std::uint32_t first = moves.empty() ? kNoNode : _arena.allocate(moves.size());
+            if (!moves.empty() && first == kNoNode) {
+                _arenaFull.store(true, std::memory_order_relaxed);
+                node.expansion.store(Expansion::Leaf);
+                return false;
+            }
+
+            for (std::size_t idx = 0; idx < moves.size(); ++idx) {
+                Node& child = _arena[first + static_cast<std::uint32_t>(idx)];
+                child.from = static_cast<std::uint8_t>(position.squareIndex(moves[idx].move.queenFrom));
+                child.to = static_cast<std::uint8_t>(position.squareIndex(moves[idx].move.queenTo));
+                child.arrow = static_cast<std::uint8_t>(position.squareIndex(moves[idx].move.arrow));
+            }
+            node.firstChild = first;
+            node.childCount = static_cast<std::uint16_t>(moves.size());
+            node.expansion.store(Expansion::Expanded, std::memory_order_release);
+            return true;
+        }
+
+        // UCT over the children progressive widening lets in. Virtual losses count as visits that
+        // scored nothing; an untried child is taken right away, in ordering order.
+        std::uint32_t selectChild(const Node& parent) const {
+            std::uint32_t parentVisits = parent.visits.load(std::memory_order_relaxed)
+                + static_cast<std::uint32_t>(std::max(0, parent.virtualLoss.load(std::memory_order_relaxed)));
+            std::uint32_t width = std::min<std::uint32_t>(parent.childCount,
+                kWideningBase + static_cast<std::uint32_t>(std::sqrt(static_cast<double>(parentVisits))));
+            double logVisits = std::log(static_cast<double>(std::max(1u, parentVisits)));
+
+            std::uint32_t best = parent.firstChild;
+            double bestValue = -1.0;
+            for (std::uint32_t idx = parent.firstChild; idx < parent.firstChild + width; ++idx) {
+                const Node& child = _arena[idx];
+                double visits = static_cast<double>(child.visits.load(std::memory_order_relaxed))
+                    + static_cast<double>(std::max(0, child.virtualLoss.load(std::memory_order_relaxed)));
+                if (visits == 0.0) {
+                    return idx;
+                }
+                double mean = static_cast<double>(child.reward.load(std::memory_order_relaxed)) / (kRewardScale * visits);
+                double value = mean + _limits.exploration * std::sqrt(logVisits / visits);
+                if (value > bestValue) {
+                    bestValue = value;
+                    best = idx;
+                }
+            }
+            return best;
+        }
+
+        // One selection, expansion, playout and backup pass; 'position' is back at the root afterwards
+        void iterate(SearchPosition& position, Rng& rng) {
+            std::array<std::uint32_t, kMaxPathLength> path;
+            int length = 0;
+            std::uint32_t current = _root;
+            while (length < kMaxPathLength) {
+                Node& node = _arena[current];
+                if (node.expansion.load(std::memory_order_acquire) != Expansion::Expanded) {
+                    bool ripe = node.visits.load(std::memory_order_relaxed) + 1 >= _limits.expandVisits;
+                    if (ripe && !_arenaFull.load(std::memory_order_relaxed) && expand(current, position, false)) {
+                        continue;
+                    }
+                    break;
+                }
+                if (node.childCount == 0) {
+                    break;
+                }
+                std::uint32_t child = selectChild(node);
+                _arena[child].virtualLoss.fetch_add(1, std::memory_order_relaxed);
+                position.makeMove(moveOf(position, _arena[child], position.currentPlayer()));
+                path[static_cast<std::size_t>(length++)] = child;
+                current = child;
+            }
+
+            Player leafPlayer = position.currentPlayer();
+            double result = playout(position, leafPlayer, _limits.playoutTurns, rng);
+
+            while (length > 0) {
+                Node& node = _arena[path[static_cast<std::size_t>(--length)]];
+                Player mover = opponentOf(position.currentPlayer());
+                double reward = mover == leafPlayer ? result : 1.0 - result;
+                node.reward.fetch_add(std::llround(reward * kRewardScale), std::memory_order_relaxed);
+                node.visits.fetch_add(1, std::memory_order_relaxed);
+                node.virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+                position.unmakeMove(moveOf(position, node, mover));
+            }
+            _arena[_root].visits.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+}
+
+namespace mcts {
+
+    // Searches 'tree' on limits.threads threads of the shared pool until the deadline
+    inline Move runSearch(SearchTree& tree, const SearchLimits& limits, std::chrono::steady_clock::time_point deadline,
+        const std::atomic_bool* cancel) {
+        if (tree.rootMoves() > 1) {
+            unsigned threads = std::max(1u, limits.threads);
+            ThreadPool::shared().run(threads, [&](std::size_t task, unsigned) {
+                tree.search(task, deadline, cancel);
+            }, threads);
+        }
+        if (cancel && cancel->load()) {
+            throw SearchCanceled();
+        }
+        return tree.bestMove();
+    }
+}
+
+inline Move getBestMoveMcts(const GameState& state, const SearchLimits& limits, const std::atomic_bool* cancel) {
+    auto deadline = std::chrono::steady_clock::now() + limits.timeBudget;
+    mcts::SearchTree tree(state, limits);
+    return mcts::runSearch(tree, limits, deadline, cancel);
+}
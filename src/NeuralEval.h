@@ -0,0 +1,203 @@
+#pragma once
+
+#include "Board.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Small quantised evaluation network, NNUE style. Inputs are one-hot tiles (own queen, opponent
+// queen, arrow on each square) plus the board size, seen from each side with Black's view flipped
+// vertically. The first layer is a 303 x 128 int16 matrix whose output, the accumulator, is kept
+// up to date on make/unmake by adding or subtracting one column per tile change. The output layer
+// clips both sides' accumulators to 0..127, side to move first, and takes an int8 dot product
+// with 256 weights. Weights are trained offline and loaded at startup; without a weights file the
+// engine keeps its hand-written evaluation.
+namespace nnue {
+
+    inline constexpr int kMaxDimension = 10;
+    inline constexpr int kMaxSquares = kMaxDimension * kMaxDimension;
+    inline constexpr int kFeatures = 3 * kMaxSquares + 3;  // tiles, then one per board size
+    inline constexpr int kHidden = 128;
+    inline constexpr int kClip = 127;
+
+    struct FileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t features;
+        std::uint32_t hidden;
+        std::int32_t outputDivisor;  // score = (dot product + output bias) / outputDivisor
+    };
+
+    inline constexpr char kFileMagic[8] = { 'A', 'M', 'Z', 'N', 'N', 'U', 'E', '1' };
+    inline constexpr std::uint32_t kFileVersion = 1;
+
+    // First-layer outputs of one position, for White's view [0] and Black's [1]
+    struct Accumulator {
+        alignas(32) std::array<std::array<std::int16_t, kHidden>, 2> values;
+    };
+
+    inline std::size_t side(Player player) { return player == Player::White ? 0 : 1; }
+
+    // Input index of 'tile' (not empty) on 'square' as seen by side 'view'
+    inline int featureIndex(std::size_t view, int dim, int square, TileContent tile) {
+        int row = square / dim;
+        int col = square % dim;
+        if (view == 1) {
+            row = dim - 1 - row;
+        }
+        int kind = 2;
+        if (isQueen(tile)) {
+            kind = (tile == TileContent::WhiteQueen) == (view == 0) ? 0 : 1;
+        }
+        return kind * kMaxSquares + row * kMaxDimension + col;
+    }
+
+    inline int dimensionFeature(int dim) { return 3 * kMaxSquares + (dim - 6) / 2; }
+
+    class Network {
+    public:
+        // Network used by the engine; loaded once at startup, read-only afterwards
+        static Network& instance() {
+            static Network network;
+            return network;
+        }
+
+        bool load(const std::string& path) {
+            _loaded = false;
+            std::ifstream in(path, std::ios::binary);
+            FileHeader header{};
+            if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+                || std::memcmp(header.magic, kFileMagic, sizeof(header.magic)) != 0 || header.version != kFileVersion
+                || header.features != kFeatures || header.hidden != kHidden || header.outputDivisor <= 0) {
+                return false;
+            }
+            _featureWeights.resize(std::size_t{ kFeatures } * kHidden);
+            bool complete = readAll(in, _featureWeights.data(), _featureWeights.size())
+                && readAll(in, _featureBias.data(), _featureBias.size())
+                && readAll(in, _outputWeights.data(), _outputWeights.size())
+                && readAll(in, &_outputBias, 1);
+            _outputDivisor = header.outputDivisor;
+            _loaded = complete;
+            return _loaded;
+        }
+
+        // Writes the weights in the format load() reads (for training tools)
+        static bool write(const std::string& path, const std::vector<std::int16_t>& featureWeights,
+            const std::array<std::int16_t, kHidden>& featureBias, const std::array<std::int8_t, 2 * kHidden>& outputWeights,
+            std::int32_t outputBias, std::int32_t outputDivisor) {
+            if (featureWeights.size() != std::size_t{ kFeatures } * kHidden) {
+                return false;
+            }
+            FileHeader header{};
+            std::memcpy(header.magic, kFileMagic, sizeof(header.magic));
+            header.version = kFileVersion;
+            header.features = kFeatures;
+            header.hidden = kHidden;
+            header.outputDivisor = outputDivisor;
+
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(featureWeights.data()), static_cast<std::streamsize>(featureWeights.size() * sizeof(std::int16_t)));
+            out.write(reinterpret_cast<const char*>(featureBias.data()), static_cast<std::streamsize>(sizeof(featureBias)));
+            out.write(reinterpret_cast<const char*>(outputWeights.data()), static_cast<std::streamsize>(sizeof(outputWeights)));
+            out.write(reinterpret_cast<const char*>(&outputBias), sizeof(outputBias));
+            return static_cast<bool>(out);
+        }
+
+        [[nodiscard]] bool isLoaded() const { return _loaded; }
+
+        // Accumulator of 'board' computed from scratch
+        void refresh(Accumulator& accumulator, const Board& board) const {
+            int dim = board.dimension();
+            for (std::size_t view = 0; view < 2; ++view) {
+                accumulator.values[view] = _featureBias;
+                addFeature(accumulator.values[view], dimensionFeature(dim), 1);
+                for (int square = 0; square < dim * dim; ++square) {
+                    TileContent tile = board.tiles()[static_cast<std::size_t>(square)];
+                    if (tile != TileContent::Empty) {
+                        addFeature(accumulator.values[view], featureIndex(view, dim, square, tile), 1);
+                    }
+                }
+            }
+        }
+
+        // The tile on 'square' changed from 'before' to 'after'
+        void update(Accumulator& accumulator, int dim, int square, TileContent before, TileContent after) const {
+            for (std::size_t view = 0; view < 2; ++view) {
+                if (before != TileContent::Empty) {
+                    addFeature(accumulator.values[view], featureIndex(view, dim, square, before), -1);
+                }
+                if (after != TileContent::Empty) {
+                    addFeature(accumulator.values[view], featureIndex(view, dim, square, after), 1);
+                }
+            }
+        }
+
+        // Score for 'toMove', on the scale of the hand-written evaluation
+        [[nodiscard]] int evaluate(const Accumulator& accumulator, Player toMove) const {
+            std::int32_t sum = dot(accumulator.values[side(toMove)], 0) + dot(accumulator.values[1 - side(toMove)], kHidden);
+            return (sum + _outputBias) / _outputDivisor;
+        }
+
+    private:
+        std::vector<std::int16_t> _featureWeights;  // kFeatures columns of kHidden
+        alignas(32) std::array<std::int16_t, kHidden> _featureBias{};
+        alignas(32) std::array<std::int8_t, 2 * kHidden> _outputWeights{};
+        std::int32_t _outputBias = 0;
+        std::int32_t _outputDivisor = 1;
+        bool _loaded = false;
+
+        template <typename T>
+        static bool readAll(std::ifstream& in, T* data, std::size_t count) {
+            return static_cast<bool>(in.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T))));
+        }
+
+        void addFeature(std::array<std::int16_t, kHidden>& values, int feature, int sign) const {
+            const std::int16_t* column = _featureWeights.data() + static_cast<std::size_t>(feature) * kHidden;
+            for (std::size_t idx = 0; idx < values.size(); ++idx) {
+                values[idx] = static_cast<std::int16_t>(values[idx] + sign * column[idx]);
+            }
+        }
+
+        // Clipped half of the output layer's input times its weights, starting at 'offset'
+        std::int32_t dot(const std::array<std::int16_t, kHidden>& values, std::size_t offset) const {
+#if defined(__AVX2__)
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i clip = _mm256_set1_epi16(kClip);
+            const __m256i ones = _mm256_set1_epi16(1);
+            __m256i sum = _mm256_setzero_si256();
+            for (std::size_t idx = 0; idx < values.size(); idx += 32) {
+                __m256i low = _mm256_load_si256(reinterpret_cast<const __m256i*>(values.data() + idx));
+                __m256i high = _mm256_load_si256(reinterpret_cast<const __m256i*>(values.data() + idx + 16));
+                low = _mm256_min_epi16(_mm256_max_epi16(low, zero), clip);
+                high = _mm256_min_epi16(_mm256_max_epi16(high, zero), clip);
+                // packus interleaves the 128-bit lanes; the permute restores the order
+                __m256i clipped = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+                __m256i weights = _mm256_load_si256(reinterpret_cast<const __m256i*>(_outputWeights.data() + offset + idx));
+                // u8 x i8 pairs summed to i16 (at most 2 * 127 * 128, no saturation), then to i32
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(clipped, weights), ones));
+            }
+            __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+            return _mm_cvtsi128_si32(half);
+#else
+            std::int32_t sum = 0;
+            for (std::size_t idx = 0; idx < values.size(); ++idx) {
+                int clipped = std::clamp<int>(values[idx], 0, kClip);
+                sum += clipped * _outputWeights[offset + idx];
+            }
+            return sum;
+#endif
+        }
+    };
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "GameState.h"
+#include "MappedFile.h"
+#include "Rules.h"
+#include "SearchPosition.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Candidate move for a book position. Weights come from the builder's searches (tools/BookGen.cpp);
+// the key is the position's canonical Zobrist hash, which includes the board dimension, so one book
+// covers every board size and all mirror and rotation images of a position. Squares are stored in
+// the canonical orientation.
+struct BookEntry {
+    std::uint64_t key = 0;
+    std::uint8_t from = 0;
+    std::uint8_t to = 0;
+    std::uint8_t arrow = 0;
+    std::uint8_t reserved = 0;
+    std::uint32_t weight = 0;
+};
+
+static_assert(sizeof(BookEntry) == 16, "book entries are stored as-is");
+
+// Opening book file: header followed by entries sorted by key (all candidates of a position are
+// adjacent), memory-mapped and binary searched in place.
+class OpeningBook {
+public:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::uint64_t entries;
+    };
+
+    static constexpr char kMagic[8] = { 'A', 'M', 'Z', 'B', 'O', 'O', 'K', '1' };
+    static constexpr std::uint32_t kVersion = 2;
+
+    // Book used by the engine; loaded once at startup, read-only afterwards
+    static OpeningBook& instance() {
+        static OpeningBook book;
+        return book;
+    }
+
+    bool load(const std::string& path) {
+        _entries = nullptr;
+        _count = 0;
+        if (!_file.open(path)) {
+            return false;
+        }
+        Header header{};
+        if (_file.size() < sizeof(header)) {
+            _file.close();
+            return false;
+        }
+        std::memcpy(&header, _file.data(), sizeof(header));
+        bool valid = std::memcmp(header.magic, kMagic, sizeof(header.magic)) == 0 && header.version == kVersion
+            && _file.size() >= sizeof(header) + header.entries * sizeof(BookEntry);
+        if (!valid) {
+            _file.close();
+            return false;
+        }
+        _entries = reinterpret_cast<const BookEntry*>(_file.data() + sizeof(header));
+        _count = static_cast<std::size_t>(header.entries);
+        return true;
+    }
+
+    [[nodiscard]] bool isLoaded() const { return _entries != nullptr; }
+
+    // Book entry for playing 'move' in 'state'
+    static BookEntry entryFor(const GameState& state, const Move& move, std::uint32_t weight) {
+        int sym = 0;
+        int dim = state.board().dimension();
+        auto square = [&](const Position& pos) { return static_cast<std::uint8_t>(symmetry::apply(sym, dim, pos.row * dim + pos.col)); };
+        BookEntry entry;
+        entry.key = zobrist::canonicalHashOf(state, sym);
+        entry.from = square(move.queenFrom);
+        entry.to = square(move.queenTo);
+        entry.arrow = square(move.arrow);
+        entry.weight = weight;
+        return entry;
+    }
+
+    // Candidates stored for the position, best weighted first, in the canonical orientation;
+    // 'sym' receives the symmetry that maps the position onto it
+    [[nodiscard]] std::vector<BookEntry> candidates(const GameState& state, int& sym) const {
+        std::vector<BookEntry> found;
+        std::uint64_t key = zobrist::canonicalHashOf(state, sym);
+        if (!_entries) {
+            return found;
+        }
+        auto byKey = [](const BookEntry& entry, std::uint64_t value) { return entry.key < value; };
+        for (const auto* entry = std::lower_bound(_entries, _entries + _count, key, byKey);
+            entry != _entries + _count && entry->key == key; ++entry) {
+            found.push_back(*entry);
+        }
+        std::stable_sort(found.begin(), found.end(), [](const BookEntry& a, const BookEntry& b) { return a.weight > b.weight; });
+        return found;
+    }
+
+    // Book move for the position: the heaviest candidate, or one drawn by weight when 'weighted'.
+    // Returns an empty Move when the position is not in the book.
+    [[nodiscard]] Move pick(const GameState& state, bool weighted) const {
+        int sym = 0;
+        auto found = candidates(state, sym);
+        Player player = state.currentPlayer();
+        int dim = state.board().dimension();
+        auto toPosition = [&](std::uint8_t square) {
+            int own = symmetry::undo(sym, dim, square);
+            return Position{ own / dim, own % dim };
+        };
+        auto toMove = [&](const BookEntry& entry) {
+            return Move{ player, toPosition(entry.from), toPosition(entry.to), toPosition(entry.arrow) };
+        };
+        // A hash collision could point at a move that is illegal here
+        found.erase(std::remove_if(found.begin(), found.end(), [&](const BookEntry& entry) {
+            return !isMoveLegal(state, toMove(entry));
+        }), found.end());
+        if (found.empty()) {
+            return {};
+        }
+        if (!weighted) {
+            return toMove(found.front());
+        }
+
+        std::uint64_t total = 0;
+        for (const auto& entry : found) {
+            total += entry.weight;
+        }
+        thread_local std::mt19937_64 rng{ std::random_device{}() };
+        std::uint64_t ticket = total ? std::uniform_int_distribution<std::uint64_t>(0, total - 1)(rng) : 0;
+        for (const auto& entry : found) {
+            if (ticket < entry.weight) {
+                return toMove(entry);
+            }
+            ticket -= entry.weight;
+        }
+        return toMove(found.front());
+    }
+
+    static bool write(const std::string& path, std::vector<BookEntry> entries) {
+        std::sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) { return a.key < b.key; });
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(header.magic));
+        header.version = kVersion;
+        header.entries = entries.size();
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(BookEntry)));
+        return static_cast<bool>(out);
+    }
+
+private:
+    MappedFile _file;
+    const BookEntry* _entries = nullptr;
+    std::size_t _count = 0;
+};
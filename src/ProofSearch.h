@@ -0,0 +1,220 @@
+#pragma once
+
+#include "GameState.h"
+#include "RegionSolver.h"
+#include "Rules.h"
+#include "SearchPosition.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+enum class ProofResult : std::uint8_t {
+    Unknown = 0,  // node budget, time or cancellation ran out first
+    Win,          // the side to move wins by playing 'move'
+    Loss          // the side to move loses against any defence
+};
+
+struct ProofOutcome {
+    ProofResult result = ProofResult::Unknown;
+    Move move;
+    std::uint64_t nodes = 0;
+};
+
+// Depth-first proof-number search (df-pn) in negamax form: phi is the proof number for "the side
+// to move wins", delta the one for "it loses". A side without a legal move has lost, and since every
+// turn fills a square the game graph has no cycles.
+namespace proof {
+
+    inline constexpr std::uint32_t kInfinity = std::numeric_limits<std::uint32_t>::max() / 2;
+
+    struct Numbers {
+        std::uint32_t phi = 1;
+        std::uint32_t delta = 1;
+    };
+
+    inline std::uint32_t saturatingAdd(std::uint32_t a, std::uint32_t b) {
+        return static_cast<std::uint32_t>(std::min<std::uint64_t>(kInfinity, std::uint64_t{ a } + b));
+    }
+
+    // Proof numbers by position hash, always-replace; unknown positions start at (1, 1)
+    class ProofTable {
+    public:
+        explicit ProofTable(std::size_t megabytes) {
+            std::size_t entries = 1;
+            while (entries * 2 * sizeof(Entry) <= megabytes * 1024 * 1024) {
+                entries *= 2;
+            }
+            _entries = std::make_unique<Entry[]>(entries);
+            _mask = entries - 1;
+        }
+
+        [[nodiscard]] Numbers lookup(std::uint64_t key) const {
+            const auto& entry = _entries[key & _mask];
+            return entry.key == key ? entry.numbers : Numbers{};
+        }
+
+        void store(std::uint64_t key, Numbers numbers) {
+            _entries[key & _mask] = { key, numbers };
+        }
+
+    private:
+        struct Entry {
+            std::uint64_t key = 0;
+            Numbers numbers;
+        };
+
+        std::unique_ptr<Entry[]> _entries;
+        std::size_t _mask = 0;
+    };
+
+    // Empty squares both sides can still get to: those of regions holding queens of both colours.
+    // Private regions are left to the region solver, which the prover calls at every node, so
+    // these squares are what the proof tree has to branch over.
+    inline int contestedSquareCount(const GameState& state) {
+        int contested = 0;
+        for (const auto& region : regions::findRegions(state.board())) {
+            contested += region.contested ? region.emptySquares : 0;
+        }
+        return contested;
+    }
+
+    // Table is ProofTable or anything with the same lookup/store interface; it outlives the prover,
+    // so a long proof can be run as several budgeted calls against one table
+    template <typename Table = ProofTable>
+    class Prover {
+    public:
+        Prover(Table& table, std::uint64_t maxNodes, std::chrono::steady_clock::time_point deadline,
+            const std::atomic_bool* cancel)
+            : _table(table)
+            , _maxNodes(maxNodes)
+            , _deadline(deadline)
+            , _cancel(cancel)
+        {
+        }
+
+        ProofOutcome prove(const GameState& state) {
+            ProofOutcome outcome;
+            auto analysis = _regions.analyse(state);
+            if (analysis.provenWin() || analysis.provenLoss()) {
+                outcome.result = analysis.provenWin() ? ProofResult::Win : ProofResult::Loss;
+                outcome.move = analysis.move;
+                return outcome;
+            }
+
+            SearchPosition position(state, false, true);
+            search(position, kInfinity, kInfinity);
+            outcome.nodes = _nodes;
+            Numbers root = _table.lookup(position.hash());
+            if (_aborted || (root.phi != 0 && root.delta != 0)) {
+                return outcome;
+            }
+            if (root.delta == 0) {
+                outcome.result = ProofResult::Loss;
+                return outcome;
+            }
+
+            // A winning move leads to a position that is lost for the opponent
+            for (const auto& move : generateMovesForPlayer(state, state.currentPlayer())) {
+                if (_table.lookup(position.hashAfter(move)).delta == 0) {
+                    outcome.result = ProofResult::Win;
+                    outcome.move = move;
+                    break;
+                }
+            }
+            return outcome;
+        }
+
+    private:
+        Table& _table;
+        regions::RegionSolver _regions;
+        std::uint64_t _maxNodes;
+        std::chrono::steady_clock::time_point _deadline;
+        const std::atomic_bool* _cancel;
+        std::uint64_t _nodes = 0;
+        bool _aborted = false;
+
+        bool outOfBudget() {
+            if (!_aborted && (++_nodes > _maxNodes || (_cancel && _cancel->load(std::memory_order_relaxed))
+                || ((_nodes & 1023) == 0 && std::chrono::steady_clock::now() >= _deadline))) {
+                _aborted = true;
+            }
+            return _aborted;
+        }
+
+        // Multiple iterative deepening: expands the node until its numbers reach a threshold
+        void search(SearchPosition& position, std::uint32_t thresholdPhi, std::uint32_t thresholdDelta) {
+            if (outOfBudget()) {
+                return;
+            }
+            std::uint64_t key = position.hash();
+
+            // Once no region is contested the outcome usually follows from the region fill counts
+            auto analysis = _regions.analyse(position.state(), position.regions());
+            if (analysis.provenWin() || analysis.provenLoss()) {
+                _table.store(key, analysis.provenWin() ? Numbers{ 0, kInfinity } : Numbers{ kInfinity, 0 });
+                return;
+            }
+
+            auto moves = generateMovesForPlayer(position.state(), position.currentPlayer());
+            if (moves.empty()) {
+                _table.store(key, { kInfinity, 0 });
+                return;
+            }
+
+            std::vector<std::uint64_t> childKeys;
+            childKeys.reserve(moves.size());
+            for (const auto& move : moves) {
+                childKeys.push_back(position.hashAfter(move));
+            }
+
+            while (true) {
+                // phi = min delta(child), delta = sum phi(child); the child with the smallest delta
+                // is the most promising proof, the runner-up bounds how long to stay in it
+                std::uint32_t delta = 0;
+                std::uint32_t bestDelta = kInfinity;
+                std::uint32_t secondDelta = kInfinity;
+                std::uint32_t bestPhi = kInfinity;
+                std::size_t best = 0;
+                for (std::size_t idx = 0; idx < childKeys.size(); ++idx) {
+                    Numbers child = _table.lookup(childKeys[idx]);
+                    delta = saturatingAdd(delta, child.phi);
+                    if (child.delta < bestDelta) {
+                        secondDelta = bestDelta;
+                        bestDelta = child.delta;
+                        bestPhi = child.phi;
+                        best = idx;
+                    }
+                    else if (child.delta < secondDelta) {
+                        secondDelta = child.delta;
+                    }
+                }
+                std::uint32_t phi = bestDelta;
+
+                if (phi >= thresholdPhi || delta >= thresholdDelta || _aborted) {
+                    _table.store(key, { phi, delta });
+                    return;
+                }
+
+                std::uint32_t childPhi = saturatingAdd(thresholdDelta - delta, bestPhi);
+                std::uint32_t childDelta = std::min(thresholdPhi, saturatingAdd(secondDelta, 1));
+                position.makeMove(moves[best]);
+                search(position, childPhi, childDelta);
+                position.unmakeMove(moves[best]);
+            }
+        }
+    };
+}
+
+// Tries to prove the position won or lost for the side to move within the given budget
+inline ProofOutcome proveEndgame(const GameState& state, std::uint64_t maxNodes, std::chrono::steady_clock::time_point deadline,
+    const std::atomic_bool* cancel = nullptr, std::size_t tableMegabytes = 16) {
+    proof::ProofTable table(tableMegabytes);
+    proof::Prover<> prover(table, maxNodes, deadline, cancel);
+    return prover.prove(state);
+}
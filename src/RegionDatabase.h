@@ -0,0 +1,521 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Exact fill values of small single-owner regions, computed offline (tools/RegionDbGen.cpp) and
+// memory-mapped at startup. A region qualifies if it holds one or two queens and its bounding box,
+// turned to be no taller than wide, fits one of the windows below: 4x4 for compact regions, 3x5,
+// 2x8 and 1x10 for elongated ones. Each window has its own table, indexed canonically: a region is
+// turned and mirrored into the orientation with the smallest mask of open cells (empty or queen),
+// anchored at the window's top-left corner, so every symmetric copy and every translation shares
+// one entry. Only connected canonical masks get a row, with a nibble per queen placement.
+namespace regions {
+
+    inline constexpr int kMaxWindowCells = 16;
+    inline constexpr int kMaxDatabaseQueens = 2;
+    inline constexpr std::uint16_t kNoRank = 0xFFFF;
+
+    struct WindowShape {
+        int rows;
+        int cols;
+    };
+
+    // A region goes to the first window it fits, so each region has exactly one table
+    inline constexpr std::array<WindowShape, 4> kWindowShapes = { { {4, 4}, {3, 5}, {2, 8}, {1, 10} } };
+    inline constexpr std::size_t kTables = kWindowShapes.size();
+
+    // Queen placements in a window of 'cells' cells: one queen, or two on different cells
+    inline constexpr std::uint32_t queenSlots(int cells) {
+        return static_cast<std::uint32_t>(cells + cells * (cells - 1) / 2);
+    }
+
+    struct DatabaseHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t tables;
+        std::uint64_t reserved;
+    };
+
+    // Followed by the rank of every window mask (kNoRank if it has no row) and then the rows of
+    // values, padded to 8 bytes
+    struct TableHeader {
+        std::uint32_t rows;
+        std::uint32_t cols;
+        std::uint32_t masks;  // masks with a row
+        std::uint32_t slots;  // values per row
+    };
+
+    inline constexpr char kDatabaseMagic[8] = { 'A', 'M', 'Z', 'R', 'E', 'G', 'D', 'B' };
+    inline constexpr std::uint32_t kDatabaseVersion = 2;
+
+    // Region in a rows x cols box: open cells as bits row * cols + col and up to two queen cells
+    struct WindowRegion {
+        int rows = 0;
+        int cols = 0;
+        std::uint16_t open = 0;
+        std::array<int, kMaxDatabaseQueens> queens{ -1, -1 };
+        int queenCount = 0;
+    };
+
+    inline std::uint32_t queenSlot(const WindowRegion& region) {
+        int cells = region.rows * region.cols;
+        if (region.queenCount == 1) {
+            return static_cast<std::uint32_t>(region.queens[0]);
+        }
+        int low = std::min(region.queens[0], region.queens[1]);
+        int high = std::max(region.queens[0], region.queens[1]);
+        return static_cast<std::uint32_t>(cells + low * cells - low * (low + 1) / 2 + (high - low - 1));
+    }
+
+    // Calls visit(cell) for every cell a queen on 'cell' of a rows x cols box reaches through 'empty'
+    template <typename Visit>
+    void forEachWindowTarget(int rows, int cols, std::uint16_t empty, int cell, Visit visit) {
+        static constexpr std::array<std::array<int, 2>, 8> kDirections = { {
+            {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
+        } };
+        for (const auto& [dr, dc] : kDirections) {
+            int row = cell / cols + dr;
+            int col = cell % cols + dc;
+            while (row >= 0 && col >= 0 && row < rows && col < cols && (empty >> (row * cols + col) & 1)) {
+                visit(row * cols + col);
+                row += dr;
+                col += dc;
+            }
+        }
+    }
+
+    // Calls visit(from, to, arrow, child) for every move of the region's queens inside its box
+    template <typename Visit>
+    void forEachWindowMove(const WindowRegion& region, Visit visit) {
+        std::uint16_t queenBits = 0;
+        for (int idx = 0; idx < region.queenCount; ++idx) {
+            queenBits |= static_cast<std::uint16_t>(1u << region.queens[static_cast<std::size_t>(idx)]);
+        }
+        std::uint16_t empty = region.open & static_cast<std::uint16_t>(~queenBits);
+        for (int idx = 0; idx < region.queenCount; ++idx) {
+            int from = region.queens[static_cast<std::size_t>(idx)];
+            forEachWindowTarget(region.rows, region.cols, empty, from, [&](int to) {
+                std::uint16_t afterStep = static_cast<std::uint16_t>((empty | (1u << from)) & ~(1u << to));
+                forEachWindowTarget(region.rows, region.cols, afterStep, to, [&](int arrow) {
+                    WindowRegion child = region;
+                    child.open = static_cast<std::uint16_t>(region.open & ~(1u << arrow));
+                    child.queens[static_cast<std::size_t>(idx)] = to;
+                    visit(from, to, arrow, child);
+                });
+            });
+        }
+    }
+
+    // The open cells 'part' of 'region' (queens included) cut out at their bounding box
+    inline WindowRegion cutOut(const WindowRegion& region, std::uint16_t part) {
+        int minRow = region.rows;
+        int minCol = region.cols;
+        int maxRow = 0;
+        int maxCol = 0;
+        for (int cell = 0; cell < region.rows * region.cols; ++cell) {
+            if (part >> cell & 1) {
+                minRow = std::min(minRow, cell / region.cols);
+                maxRow = std::max(maxRow, cell / region.cols);
+                minCol = std::min(minCol, cell % region.cols);
+                maxCol = std::max(maxCol, cell % region.cols);
+            }
+        }
+        WindowRegion cut;
+        cut.rows = maxRow - minRow + 1;
+        cut.cols = maxCol - minCol + 1;
+        auto cellOf = [&](int cell) { return (cell / region.cols - minRow) * cut.cols + cell % region.cols - minCol; };
+        for (int cell = 0; cell < region.rows * region.cols; ++cell) {
+            if (part >> cell & 1) {
+                cut.open |= static_cast<std::uint16_t>(1u << cellOf(cell));
+            }
+        }
+        for (int idx = 0; idx < region.queenCount; ++idx) {
+            int queen = region.queens[static_cast<std::size_t>(idx)];
+            if (part >> queen & 1) {
+                cut.queens[static_cast<std::size_t>(cut.queenCount++)] = cellOf(queen);
+            }
+        }
+        return cut;
+    }
+
+    // Calls visit(part) for every 8-connected group of open cells of 'region' that holds a queen,
+    // cut out at its bounding box
+    template <typename Visit>
+    void forEachPart(const WindowRegion& region, Visit visit) {
+        std::uint16_t seen = 0;
+        for (int idx = 0; idx < region.queenCount; ++idx) {
+            int start = region.queens[static_cast<std::size_t>(idx)];
+            if (seen >> start & 1) {
+                continue;
+            }
+            std::uint16_t part = static_cast<std::uint16_t>(1u << start);
+            std::array<int, kMaxWindowCells> stack;
+            int depth = 0;
+            stack[static_cast<std::size_t>(depth++)] = start;
+            while (depth > 0) {
+                int cell = stack[static_cast<std::size_t>(--depth)];
+                int row = cell / region.cols;
+                int col = cell % region.cols;
+                for (int r = std::max(0, row - 1); r <= std::min(region.rows - 1, row + 1); ++r) {
+                    for (int c = std::max(0, col - 1); c <= std::min(region.cols - 1, col + 1); ++c) {
+                        int next = r * region.cols + c;
+                        if ((region.open >> next & 1) && !(part >> next & 1)) {
+                            part |= static_cast<std::uint16_t>(1u << next);
+                            stack[static_cast<std::size_t>(depth++)] = next;
+                        }
+                    }
+                }
+            }
+            seen |= part;
+            visit(cutOut(region, part));
+        }
+    }
+
+    // 'region' under one of the 8 symmetries of a rectangle: bit 2 swaps rows and columns, then
+    // bits 0 and 1 mirror the rows and the columns
+    inline WindowRegion transformed(const WindowRegion& region, int symmetry) {
+        bool swap = (symmetry & 4) != 0;
+        WindowRegion result;
+        result.rows = swap ? region.cols : region.rows;
+        result.cols = swap ? region.rows : region.cols;
+        auto cellOf = [&](int cell) {
+            int row = cell / region.cols;
+            int col = cell % region.cols;
+            if (swap) {
+                std::swap(row, col);
+            }
+            if (symmetry & 1) {
+                row = result.rows - 1 - row;
+            }
+            if (symmetry & 2) {
+                col = result.cols - 1 - col;
+            }
+            return row * result.cols + col;
+        };
+        for (int cell = 0; cell < region.rows * region.cols; ++cell) {
+            if (region.open >> cell & 1) {
+                result.open |= static_cast<std::uint16_t>(1u << cellOf(cell));
+            }
+        }
+        result.queenCount = region.queenCount;
+        for (int idx = 0; idx < region.queenCount; ++idx) {
+            result.queens[static_cast<std::size_t>(idx)] = cellOf(region.queens[static_cast<std::size_t>(idx)]);
+        }
+        return result;
+    }
+
+    // The same region at the top-left corner of window 'shape'
+    inline WindowRegion placed(const WindowRegion& region, const WindowShape& shape) {
+        WindowRegion result;
+        result.rows = shape.rows;
+        result.cols = shape.cols;
+        auto cellOf = [&](int cell) { return cell / region.cols * shape.cols + cell % region.cols; };
+        for (int cell = 0; cell < region.rows * region.cols; ++cell) {
+            if (region.open >> cell & 1) {
+                result.open |= static_cast<std::uint16_t>(1u << cellOf(cell));
+            }
+        }
+        result.queenCount = region.queenCount;
+        for (int idx = 0; idx < region.queenCount; ++idx) {
+            result.queens[static_cast<std::size_t>(idx)] = cellOf(region.queens[static_cast<std::size_t>(idx)]);
+        }
+        return result;
+    }
+
+    // Table of a rows x cols bounding box with rows <= cols, -1 if no window fits
+    inline int tableFor(int rows, int cols) {
+        for (std::size_t table = 0; table < kTables; ++table) {
+            if (rows <= kWindowShapes[table].rows && cols <= kWindowShapes[table].cols) {
+                return static_cast<int>(table);
+            }
+        }
+        return -1;
+    }
+
+    struct CanonicalRegion {
+        int table = -1;  // -1 if the region is too large or has too many queens
+        std::uint16_t mask = 0;
+        std::uint32_t slot = 0;
+    };
+
+    // Table entry of a region cut out at its bounding box: of the symmetries that leave it no
+    // taller than wide, the one with the smallest mask, and of those the smallest queen slot
+    inline CanonicalRegion canonical(const WindowRegion& region) {
+        CanonicalRegion best;
+        int rows = std::min(region.rows, region.cols);
+        int table = tableFor(rows, std::max(region.rows, region.cols));
+        if (table < 0 || region.queenCount > kMaxDatabaseQueens) {
+            return best;
+        }
+        for (int symmetry = 0; symmetry < 8; ++symmetry) {
+            if (((symmetry & 4) ? region.cols : region.rows) != rows) {
+                continue;
+            }
+            WindowRegion candidate = placed(transformed(region, symmetry), kWindowShapes[static_cast<std::size_t>(table)]);
+            std::uint32_t slot = candidate.queenCount > 0 ? queenSlot(candidate) : 0;
+            if (best.table < 0 || candidate.open < best.mask || (candidate.open == best.mask && slot < best.slot)) {
+                best = { table, candidate.open, slot };
+            }
+        }
+        return best;
+    }
+
+    // One table as lookups see it: the rank of every window mask and the rows of values, packed
+    // in nibbles as in the file or a byte each while the table is generated
+    struct TableView {
+        std::uint32_t slots = 0;
+        const std::uint16_t* ranks = nullptr;
+        const std::uint8_t* values = nullptr;
+        bool packed = true;
+
+        [[nodiscard]] int value(std::uint16_t mask, std::uint32_t slot) const {
+            std::uint16_t rank = ranks[mask];
+            if (rank == kNoRank) {
+                return -1;
+            }
+            std::size_t index = std::size_t{ rank } * slots + slot;
+            return packed ? (values[index / 2] >> ((index & 1) * 4)) & 0xF : values[index];
+        }
+    };
+
+    using TableViews = std::array<TableView, kTables>;
+
+    // Fill value of 'region' from 'tables': the sum over its parts, which can't interact;
+    // -1 if some part has no entry
+    inline int fillValue(const TableViews& tables, const WindowRegion& region) {
+        int total = 0;
+        forEachPart(region, [&](const WindowRegion& part) {
+            CanonicalRegion entry = canonical(part);
+            int value = entry.table < 0 || total < 0 ? -1 : tables[static_cast<std::size_t>(entry.table)].value(entry.mask, entry.slot);
+            total = value < 0 ? -1 : total + value;
+        });
+        return total;
+    }
+
+    // Masks a table keeps a row for: connected, anchored at the top-left corner, belonging to this
+    // window and canonical. Rows are in mask order, so the layout follows from the shapes alone.
+    struct TableLayout {
+        WindowShape shape{};
+        std::uint32_t slots = 0;
+        std::vector<std::uint16_t> ranks;  // per window mask
+        std::vector<std::uint16_t> masks;  // per rank
+    };
+
+    inline TableLayout tableLayout(std::size_t table) {
+        TableLayout layout;
+        layout.shape = kWindowShapes[table];
+        int cells = layout.shape.rows * layout.shape.cols;
+        layout.slots = queenSlots(cells);
+        layout.ranks.assign(std::size_t{ 1 } << cells, kNoRank);
+        for (std::uint32_t mask = 1; mask < (1u << cells); ++mask) {
+            WindowRegion window;
+            window.rows = layout.shape.rows;
+            window.cols = layout.shape.cols;
+            window.open = static_cast<std::uint16_t>(mask);
+            window.queens[0] = 0;
+            window.queenCount = 1;
+            while (!(mask >> window.queens[0] & 1)) {
+                ++window.queens[0];
+            }
+            int parts = 0;
+            WindowRegion cut;
+            forEachPart(window, [&](const WindowRegion& part) { cut = part; ++parts; });
+            cut.queenCount = 0;
+            if (parts == 1 && placed(cut, layout.shape).open == mask) {
+                CanonicalRegion entry = canonical(cut);
+                if (entry.table == static_cast<int>(table) && entry.mask == mask) {
+                    layout.ranks[mask] = static_cast<std::uint16_t>(layout.masks.size());
+                    layout.masks.push_back(static_cast<std::uint16_t>(mask));
+                }
+            }
+        }
+        return layout;
+    }
+
+    class RegionDatabase {
+    public:
+        // Values of every table, a byte each, as generate() returns them
+        struct Tables {
+            std::array<TableLayout, kTables> layouts;
+            std::array<std::vector<std::uint8_t>, kTables> values;
+        };
+
+        // Database used by the engine; loaded once at startup, read-only afterwards
+        static RegionDatabase& instance() {
+            static RegionDatabase database;
+            return database;
+        }
+
+        bool load(const std::string& path) {
+            _loaded = false;
+            if (!_file.open(path)) {
+                return false;
+            }
+            DatabaseHeader header{};
+            std::size_t offset = sizeof(header);
+            bool valid = _file.size() >= offset;
+            if (valid) {
+                std::memcpy(&header, _file.data(), sizeof(header));
+                valid = std::memcmp(header.magic, kDatabaseMagic, sizeof(header.magic)) == 0
+                    && header.version == kDatabaseVersion && header.tables == kTables;
+            }
+            for (std::size_t table = 0; valid && table < kTables; ++table) {
+                TableHeader tableHeader{};
+                valid = _file.size() >= offset + sizeof(tableHeader);
+                if (!valid) {
+                    break;
+                }
+                std::memcpy(&tableHeader, _file.data() + offset, sizeof(tableHeader));
+                const WindowShape& shape = kWindowShapes[table];
+                std::size_t masks = std::size_t{ 1 } << (shape.rows * shape.cols);
+                valid = tableHeader.rows == static_cast<std::uint32_t>(shape.rows) && tableHeader.cols == static_cast<std::uint32_t>(shape.cols)
+                    && tableHeader.slots == queenSlots(shape.rows * shape.cols)
+                    && _file.size() >= offset + tableSize(masks, tableHeader.masks, tableHeader.slots);
+                if (valid) {
+                    const unsigned char* ranks = _file.data() + offset + sizeof(tableHeader);
+                    _tables[table] = { tableHeader.slots, reinterpret_cast<const std::uint16_t*>(ranks),
+                        ranks + masks * sizeof(std::uint16_t), true };
+                    offset += tableSize(masks, tableHeader.masks, tableHeader.slots);
+                }
+            }
+            if (!valid) {
+                _file.close();
+                return false;
+            }
+            _loaded = true;
+            return true;
+        }
+
+        [[nodiscard]] bool isLoaded() const { return _loaded; }
+
+        // Fill value of 'region' (one or more parts, up to two queens); -1 if it isn't covered
+        [[nodiscard]] int value(const WindowRegion& region) const { return fillValue(_tables, region); }
+
+        // Builds the tables by increasing number of open cells: every move fills one cell, so all
+        // parts of a child live in the layers below, in whichever table. Masks of one layer are
+        // split over threads.
+        static Tables generate(unsigned threads) {
+            threads = std::max(1u, threads);
+            Tables tables;
+            TableViews views;
+            std::array<std::vector<std::pair<std::size_t, std::uint16_t>>, kMaxWindowCells + 1> layers;
+            for (std::size_t table = 0; table < kTables; ++table) {
+                tables.layouts[table] = tableLayout(table);
+                const TableLayout& layout = tables.layouts[table];
+                tables.values[table].assign(layout.masks.size() * layout.slots, 0);
+                views[table] = { layout.slots, layout.ranks.data(), tables.values[table].data(), false };
+                for (std::uint16_t mask : layout.masks) {
+                    layers[static_cast<std::size_t>(popCount(mask))].emplace_back(table, mask);
+                }
+            }
+
+            for (const auto& layer : layers) {
+                auto work = [&](unsigned worker) {
+                    for (std::size_t idx = worker; idx < layer.size(); idx += threads) {
+                        solveMask(tables, views, layer[idx].first, layer[idx].second);
+                    }
+                };
+                std::vector<std::thread> pool;
+                for (unsigned worker = 1; worker < threads; ++worker) {
+                    pool.emplace_back(work, worker);
+                }
+                work(0);
+                for (auto& thread : pool) {
+                    thread.join();
+                }
+            }
+            return tables;
+        }
+
+        static bool write(const std::string& path, const Tables& tables) {
+            DatabaseHeader header{};
+            std::memcpy(header.magic, kDatabaseMagic, sizeof(header.magic));
+            header.version = kDatabaseVersion;
+            header.tables = kTables;
+
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            for (std::size_t table = 0; table < kTables; ++table) {
+                const TableLayout& layout = tables.layouts[table];
+                TableHeader tableHeader{ static_cast<std::uint32_t>(layout.shape.rows), static_cast<std::uint32_t>(layout.shape.cols),
+                    static_cast<std::uint32_t>(layout.masks.size()), layout.slots };
+                const auto& values = tables.values[table];
+                std::size_t ranksSize = layout.ranks.size() * sizeof(std::uint16_t);
+                std::vector<std::uint8_t> packed(tableSize(layout.ranks.size(), layout.masks.size(), layout.slots) - sizeof(tableHeader) - ranksSize, 0);
+                for (std::size_t index = 0; index < values.size(); ++index) {
+                    packed[index / 2] |= static_cast<std::uint8_t>((values[index] & 0xF) << ((index & 1) * 4));
+                }
+                out.write(reinterpret_cast<const char*>(&tableHeader), sizeof(tableHeader));
+                out.write(reinterpret_cast<const char*>(layout.ranks.data()), static_cast<std::streamsize>(ranksSize));
+                out.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+            }
+            return static_cast<bool>(out);
+        }
+
+    private:
+        MappedFile _file;
+        TableViews _tables{};
+        bool _loaded = false;
+
+        // Header, ranks and packed values of one table, padded to 8 bytes
+        static constexpr std::size_t tableSize(std::size_t windowMasks, std::size_t rows, std::size_t slots) {
+            std::size_t size = sizeof(TableHeader) + windowMasks * sizeof(std::uint16_t) + (rows * slots + 1) / 2;
+            return (size + 7) / 8 * 8;
+        }
+
+        static int popCount(std::uint32_t bits) {
+            int count = 0;
+            for (; bits; bits &= bits - 1) {
+                ++count;
+            }
+            return count;
+        }
+
+        // Every one- and two-queen placement on the open cells of 'mask'
+        static void solveMask(Tables& tables, const TableViews& views, std::size_t table, std::uint16_t mask) {
+            const TableLayout& layout = tables.layouts[table];
+            std::uint8_t* row = tables.values[table].data() + std::size_t{ layout.ranks[mask] } * layout.slots;
+            WindowRegion region;
+            region.rows = layout.shape.rows;
+            region.cols = layout.shape.cols;
+            region.open = mask;
+            int cells = region.rows * region.cols;
+            for (int first = 0; first < cells; ++first) {
+                if (!(mask >> first & 1)) {
+                    continue;
+                }
+                region.queenCount = 1;
+                region.queens = { first, -1 };
+                row[queenSlot(region)] = solveState(views, region);
+
+                region.queenCount = 2;
+                for (int second = first + 1; second < cells; ++second) {
+                    if (mask >> second & 1) {
+                        region.queens = { first, second };
+                        row[queenSlot(region)] = solveState(views, region);
+                    }
+                }
+            }
+        }
+
+        static std::uint8_t solveState(const TableViews& views, const WindowRegion& region) {
+            int empty = popCount(region.open) - region.queenCount;
+            int best = 0;
+            forEachWindowMove(region, [&](int, int, int, const WindowRegion& child) {
+                if (best < empty) {
+                    best = std::max(best, 1 + fillValue(views, child));
+                }
+            });
+            return static_cast<std::uint8_t>(best);
+        }
+    };
+}
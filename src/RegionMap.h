@@ -0,0 +1,265 @@
+#pragma once
+
+#include "Board.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace regions {
+
+    // Regions of the board kept up to date one tile change at a time: every non-arrow square has
+    // the id of its 8-connected component, and every component its size and queens of each colour.
+    // Arrows only add walls, so a change can only split a region, and only if the open squares
+    // around the new arrow don't connect to each other through its ring of neighbours; just then
+    // are the parts flood filled and all but the largest relabelled. Taking an arrow back undoes
+    // its split from a log, so arrows must be removed in the reverse order of placing them.
+    class RegionMap {
+    public:
+        static constexpr int kMaxSquares = 100;
+        static constexpr std::uint8_t kNone = 0xFF;  // region id of an arrow
+
+        explicit RegionMap(const Board& board)
+            : _dim(board.dimension())
+        {
+            _id.fill(kNone);
+            for (int square = kMaxSquares - 1; square >= 0; --square) {
+                _free.push_back(static_cast<std::uint8_t>(square));
+            }
+            for (int square = 0; square < _dim * _dim; ++square) {
+                _tiles[static_cast<std::size_t>(square)] = board.tiles()[static_cast<std::size_t>(square)];
+            }
+            for (int square = 0; square < _dim * _dim; ++square) {
+                if (_tiles[static_cast<std::size_t>(square)] != TileContent::Arrow && _id[static_cast<std::size_t>(square)] == kNone) {
+                    std::uint8_t id = allocate();
+                    _id[static_cast<std::size_t>(square)] = id;
+                    std::vector<int> area{ square };
+                    fillFrom(area, [](int) { return true; }, id);
+                    for (int member : area) {
+                        count(id, member, 1);
+                    }
+                }
+            }
+        }
+
+        // The tile on 'square' changes from 'before' to 'after'
+        void set(int square, TileContent before, TileContent after) {
+            if (after == TileContent::Arrow) {
+                count(_id[static_cast<std::size_t>(square)], square, -1);
+                _tiles[static_cast<std::size_t>(square)] = after;
+                addArrow(square);
+            }
+            else if (before == TileContent::Arrow) {
+                removeArrow(square);
+                _tiles[static_cast<std::size_t>(square)] = after;
+                count(_id[static_cast<std::size_t>(square)], square, 1);
+            }
+            else {
+                std::uint8_t id = _id[static_cast<std::size_t>(square)];
+                count(id, square, -1);
+                _tiles[static_cast<std::size_t>(square)] = after;
+                count(id, square, 1);
+            }
+        }
+
+        // Region id of 'square', kNone for an arrow
+        [[nodiscard]] std::uint8_t regionOf(int square) const { return _id[static_cast<std::size_t>(square)]; }
+        // Squares of region 'id', queens included
+        [[nodiscard]] int size(std::uint8_t id) const { return _stats[id].size; }
+        [[nodiscard]] int queens(std::uint8_t id, Player player) const { return _stats[id].queens[player == Player::White ? 0 : 1]; }
+        // Regions holding queens of both colours
+        [[nodiscard]] int contestedRegions() const { return _contested; }
+
+    private:
+        struct Stats {
+            int size = 0;
+            std::array<int, 2> queens{};
+        };
+
+        // One placed arrow: its region, and the regions split off it (squares relabelled from
+        // _relabelled[relabelledFrom], ids from _created[createdFrom])
+        struct Split {
+            std::uint8_t region;
+            std::size_t relabelledFrom;
+            std::size_t createdFrom;
+        };
+
+        int _dim = 0;
+        std::array<TileContent, kMaxSquares> _tiles{};
+        std::array<std::uint8_t, kMaxSquares> _id{};
+        std::array<Stats, kMaxSquares> _stats{};
+        std::vector<std::uint8_t> _free;
+        int _contested = 0;
+        std::vector<Split> _log;
+        std::vector<int> _relabelled;
+        std::vector<std::uint8_t> _created;
+
+        [[nodiscard]] bool contested(std::uint8_t id) const { return _stats[id].queens[0] > 0 && _stats[id].queens[1] > 0; }
+
+        std::uint8_t allocate() {
+            std::uint8_t id = _free.back();
+            _free.pop_back();
+            _stats[id] = {};
+            return id;
+        }
+
+        // Adds (delta 1) or removes (-1) 'square' with its current tile to region 'id'
+        void count(std::uint8_t id, int square, int delta) {
+            _contested -= contested(id);
+            _stats[id].size += delta;
+            TileContent tile = _tiles[static_cast<std::size_t>(square)];
+            if (isQueen(tile)) {
+                _stats[id].queens[tile == TileContent::WhiteQueen ? 0 : 1] += delta;
+            }
+            _contested += contested(id);
+        }
+
+        // Calls visit(neighbour) for the up to 8 squares around 'square'
+        template <typename Visit>
+        void forEachNeighbour(int square, Visit visit) const {
+            int row = square / _dim;
+            int col = square % _dim;
+            for (int dr = -1; dr <= 1; ++dr) {
+                for (int dc = -1; dc <= 1; ++dc) {
+                    int r = row + dr;
+                    int c = col + dc;
+                    if ((dr != 0 || dc != 0) && r >= 0 && c >= 0 && r < _dim && c < _dim) {
+                        visit(r * _dim + c);
+                    }
+                }
+            }
+        }
+
+        // Grows 'area' (its squares already labelled 'id') over the neighbours 'include' accepts
+        // that aren't arrows or labelled 'id' yet, labelling them 'id'
+        template <typename Include>
+        void fillFrom(std::vector<int>& area, Include include, std::uint8_t id) {
+            for (std::size_t next = 0; next < area.size(); ++next) {
+                forEachNeighbour(area[next], [&](int neighbour) {
+                    auto idx = static_cast<std::size_t>(neighbour);
+                    if (_tiles[idx] != TileContent::Arrow && _id[idx] != id && include(neighbour)) {
+                        _id[idx] = id;
+                        area.push_back(neighbour);
+                    }
+                });
+            }
+        }
+
+        // Open neighbours of 'square' in ring order, or -1 where the ring is closed
+        [[nodiscard]] std::array<int, 8> ring(int square) const {
+            static constexpr std::array<std::array<int, 2>, 8> kRing = { {
+                {-1, 0}, {-1, 1}, {0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}
+            } };
+            std::array<int, 8> cells;
+            int row = square / _dim;
+            int col = square % _dim;
+            for (std::size_t idx = 0; idx < kRing.size(); ++idx) {
+                int r = row + kRing[idx][0];
+                int c = col + kRing[idx][1];
+                bool open = r >= 0 && c >= 0 && r < _dim && c < _dim && _tiles[static_cast<std::size_t>(r * _dim + c)] != TileContent::Arrow;
+                cells[idx] = open ? r * _dim + c : -1;
+            }
+            return cells;
+        }
+
+        // One open ring square per group of ring squares that touch each other: neighbours along
+        // the ring always do, and so do the orthogonal squares on either side of a diagonal one
+        [[nodiscard]] std::vector<int> ringGroups(const std::array<int, 8>& cells) const {
+            std::array<std::size_t, 8> parent{};
+            for (std::size_t idx = 0; idx < parent.size(); ++idx) {
+                parent[idx] = idx;
+            }
+            auto root = [&](std::size_t idx) {
+                while (parent[idx] != idx) {
+                    idx = parent[idx];
+                }
+                return idx;
+            };
+            auto join = [&](std::size_t a, std::size_t b) {
+                if (cells[a] >= 0 && cells[b] >= 0) {
+                    parent[root(a)] = root(b);
+                }
+            };
+            for (std::size_t idx = 0; idx < 8; ++idx) {
+                join(idx, (idx + 1) % 8);
+                if (idx % 2 == 0) {
+                    join(idx, (idx + 2) % 8);
+                }
+            }
+            std::vector<int> groups;
+            for (std::size_t idx = 0; idx < 8; ++idx) {
+                if (cells[idx] >= 0 && root(idx) == idx) {
+                    groups.push_back(cells[idx]);
+                }
+            }
+            return groups;
+        }
+
+        void addArrow(int square) {
+            std::uint8_t id = _id[static_cast<std::size_t>(square)];
+            Split split{ id, _relabelled.size(), _created.size() };
+            _id[static_cast<std::size_t>(square)] = kNone;
+
+            std::vector<int> groups = ringGroups(ring(square));
+            if (groups.size() > 1) {
+                splitRegion(id, groups);
+            }
+            _log.push_back(split);
+        }
+
+        // Region 'id' may have fallen apart between the squares of 'seeds'. Each part is found by
+        // filling it with a fresh id; the largest one gets 'id' back.
+        void splitRegion(std::uint8_t id, const std::vector<int>& seeds) {
+            std::vector<std::vector<int>> parts;
+            std::vector<std::uint8_t> ids;
+            for (int seed : seeds) {
+                if (_id[static_cast<std::size_t>(seed)] != id) {
+                    continue;  // reached from an earlier seed
+                }
+                std::uint8_t part = allocate();
+                _id[static_cast<std::size_t>(seed)] = part;
+                std::vector<int> area{ seed };
+                fillFrom(area, [&](int neighbour) { return _id[static_cast<std::size_t>(neighbour)] == id; }, part);
+                parts.push_back(std::move(area));
+                ids.push_back(part);
+            }
+
+            auto largest = std::max_element(parts.begin(), parts.end(),
+                [](const std::vector<int>& a, const std::vector<int>& b) { return a.size() < b.size(); }) - parts.begin();
+            for (std::size_t idx = 0; idx < parts.size(); ++idx) {
+                if (static_cast<std::ptrdiff_t>(idx) == largest) {
+                    for (int member : parts[idx]) {
+                        _id[static_cast<std::size_t>(member)] = id;
+                    }
+                    _free.push_back(ids[idx]);
+                    continue;
+                }
+                for (int member : parts[idx]) {
+                    count(id, member, -1);
+                    count(ids[idx], member, 1);
+                    _relabelled.push_back(member);
+                }
+                _created.push_back(ids[idx]);
+            }
+        }
+
+        void removeArrow(int square) {
+            Split split = _log.back();
+            _log.pop_back();
+            for (std::size_t idx = split.relabelledFrom; idx < _relabelled.size(); ++idx) {
+                int member = _relabelled[idx];
+                count(_id[static_cast<std::size_t>(member)], member, -1);
+                _id[static_cast<std::size_t>(member)] = split.region;
+                count(split.region, member, 1);
+            }
+            _relabelled.resize(split.relabelledFrom);
+            for (std::size_t idx = _created.size(); idx-- > split.createdFrom;) {
+                _free.push_back(_created[idx]);
+            }
+            _created.resize(split.createdFrom);
+
+            _id[static_cast<std::size_t>(square)] = split.region;
+        }
+    };
+}
@@ -0,0 +1,351 @@
+#pragma once
+
+#include "DistanceMap.h"
+#include "GameState.h"
+#include "RegionDatabase.h"
+#include "Rules.h"
+#include "SearchPosition.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Endgames by region. Arrows split the board into independent regions; once no region holds queens
+// of both colours, each one is a one-player puzzle (how many more moves can its queens make, given
+// that every move fills exactly one square?) and the game is decided by the totals: the side to move
+// wins iff it can make more moves than the opponent.
+namespace regions {
+
+    inline constexpr int kMaxReachable = 36;  // a queen reaches at most 35 squares on 10x10
+
+    struct Region {
+        std::vector<int> squares; // every square of the region, queens included
+        std::vector<int> queens;  // squares of the queens inside
+        Player owner = Player::None;
+        bool contested = false;   // holds queens of both colours
+        int emptySquares = 0;
+        std::uint64_t key = 0;    // identifies the region's empty squares and queen squares
+    };
+
+    // Key of a square inside a region; queens of either colour share a key since fill values don't
+    // depend on the colour
+    inline std::uint64_t emptyKey(int square) { return zobrist::kKeys.tiles[2][static_cast<std::size_t>(square)]; }
+    inline std::uint64_t queenKey(int square) { return zobrist::kKeys.tiles[0][static_cast<std::size_t>(square)]; }
+
+    // 8-connected components of non-arrow squares that hold at least one queen. Queens move along
+    // lines of such squares, so no move ever leaves its region.
+    inline std::vector<Region> findRegions(const Board& board) {
+        int dim = board.dimension();
+        const auto& tiles = board.tiles();
+        distance::Occupancy occupancy(tiles, dim);
+        distance::Bitboard queens = occupancy.white | occupancy.black;
+        distance::Bitboard open = occupancy.empty | queens;
+        distance::Bitboard seen;
+        std::vector<Region> found;
+
+        distance::forEachBit(queens, [&](int start) {
+            if (seen.test(start)) {
+                return;
+            }
+            distance::Bitboard seed;
+            seed.set(start);
+            distance::Bitboard area = distance::connected(seed, open, dim);
+            seen |= area;
+
+            Region region;
+            region.key = zobrist::kKeys.dimension[static_cast<std::size_t>(dim)];
+            distance::forEachBit(area, [&](int bit) {
+                int square = occupancy.squareOf(bit);
+                TileContent tile = tiles[static_cast<std::size_t>(square)];
+                region.squares.push_back(square);
+                if (isQueen(tile)) {
+                    Player player = tile == TileContent::WhiteQueen ? Player::White : Player::Black;
+                    region.contested = region.contested || (region.owner != Player::None && region.owner != player);
+                    region.owner = player;
+                    region.queens.push_back(square);
+                    region.key ^= queenKey(square);
+                }
+                else {
+                    ++region.emptySquares;
+                    region.key ^= emptyKey(square);
+                }
+            });
+            if (region.contested) {
+                region.owner = Player::None;
+            }
+            found.push_back(std::move(region));
+        });
+        return found;
+    }
+
+    // Same regions in the same order from a region map, without flood filling
+    inline std::vector<Region> findRegions(const Board& board, const RegionMap& map) {
+        int dim = board.dimension();
+        const auto& tiles = board.tiles();
+        // Regions are numbered by their first queen in row-major order, like the fill above
+        std::array<int, RegionMap::kMaxSquares> slot;
+        slot.fill(-1);
+        std::vector<Region> found;
+        for (int square = 0; square < dim * dim; ++square) {
+            std::uint8_t id = map.regionOf(square);
+            if (isQueen(tiles[static_cast<std::size_t>(square)]) && slot[id] < 0) {
+                slot[id] = static_cast<int>(found.size());
+                found.emplace_back();
+                found.back().key = zobrist::kKeys.dimension[static_cast<std::size_t>(dim)];
+            }
+        }
+
+        for (int square = 0; square < dim * dim; ++square) {
+            std::uint8_t id = map.regionOf(square);
+            if (id == RegionMap::kNone || slot[id] < 0) {
+                continue;
+            }
+            Region& region = found[static_cast<std::size_t>(slot[id])];
+            TileContent tile = tiles[static_cast<std::size_t>(square)];
+            region.squares.push_back(square);
+            if (isQueen(tile)) {
+                Player player = tile == TileContent::WhiteQueen ? Player::White : Player::Black;
+                region.contested = region.contested || (region.owner != Player::None && region.owner != player);
+                region.owner = player;
+                region.queens.push_back(square);
+                region.key ^= queenKey(square);
+            }
+            else {
+                ++region.emptySquares;
+                region.key ^= emptyKey(square);
+            }
+        }
+        for (auto& region : found) {
+            if (region.contested) {
+                region.owner = Player::None;
+            }
+        }
+        return found;
+    }
+
+    // Number of moves still available to a player; exact when lower == upper
+    struct FillBounds {
+        int lower = 0;
+        int upper = 0;
+    };
+
+    struct RegionAnalysis {
+        bool settled = false;  // no region holds queens of both colours
+        FillBounds own;        // for the side to move
+        FillBounds opponent;
+        Move move;             // first move of the longest line found for the side to move, if any
+
+        [[nodiscard]] bool provenWin() const { return settled && own.lower > opponent.upper; }
+        [[nodiscard]] bool provenLoss() const { return settled && own.upper <= opponent.lower; }
+    };
+
+    // Solves settled regions by depth-first search over fill sequences, memoising exact values by
+    // region key. A region whose search runs out of nodes gets bounds instead: the longest line
+    // found and its number of empty squares. Regions 'database' covers (if it is loaded) are
+    // looked up instead of searched.
+    class RegionSolver {
+    public:
+        explicit RegionSolver(std::uint64_t nodesPerRegion = 50000, const RegionDatabase* database = &RegionDatabase::instance())
+            : _nodesPerRegion(nodesPerRegion)
+            , _database(database)
+        {
+        }
+
+        FillBounds solve(const Board& board, const Region& region, Move* firstMove) {
+            _dim = board.dimension();
+            WindowRegion window;
+            int origin = 0;
+            int value = _database && _database->isLoaded() && toWindow(region, window, origin) ? _database->value(window) : -1;
+            if (value >= 0) {
+                bool found = false;
+                if (firstMove && value > 0) {
+                    forEachWindowMove(window, [&](int from, int to, int arrow, const WindowRegion& child) {
+                        if (!found && 1 + _database->value(child) == value) {
+                            found = true;
+                            *firstMove = { Player::None, positionOf(window, origin, from), positionOf(window, origin, to),
+                                positionOf(window, origin, arrow) };
+                        }
+                    });
+                }
+                return { value, value };
+            }
+
+            auto cached = _solved.find(region.key);
+            if (cached == _solved.end()) {
+                _tiles = board.tiles();
+                _queens = region.queens;
+                _budget = _nodesPerRegion;
+
+                bool exact = true;
+                Move line;
+                int best = longestFill(region.emptySquares, region.key, exact, &line);
+                if (_solved.size() > (1u << 16)) {
+                    _solved.clear();
+                }
+                cached = _solved.emplace(region.key, SolvedRegion{ { best, exact ? best : region.emptySquares }, line }).first;
+            }
+            if (firstMove) {
+                *firstMove = cached->second.line;
+            }
+            return cached->second.bounds;
+        }
+
+        // 'map', if given, is the region map of 'state' (SearchPosition::regions)
+        RegionAnalysis analyse(const GameState& state, const RegionMap* map = nullptr) {
+            RegionAnalysis analysis;
+            if (map && map->contestedRegions() > 0) {
+                return analysis;
+            }
+            Player mover = state.currentPlayer();
+            auto found = map ? findRegions(state.board(), *map) : findRegions(state.board());
+            if (std::any_of(found.begin(), found.end(), [](const Region& region) { return region.contested; })) {
+                return analysis;
+            }
+
+            analysis.settled = true;
+            for (const auto& region : found) {
+                bool own = region.owner == mover;
+                Move line;
+                FillBounds bounds = solve(state.board(), region, own ? &line : nullptr);
+                FillBounds& total = own ? analysis.own : analysis.opponent;
+                total.lower += bounds.lower;
+                total.upper += bounds.upper;
+                if (own && bounds.lower > 0 && analysis.move.player == Player::None) {
+                    line.player = mover;
+                    analysis.move = line;
+                }
+            }
+            return analysis;
+        }
+
+    private:
+        struct SolvedRegion {
+            FillBounds bounds;
+            Move line;
+        };
+
+        std::unordered_map<std::uint64_t, SolvedRegion> _solved;     // whole regions, bounds and first move
+        std::unordered_map<std::uint64_t, std::uint8_t> _memo;       // exact values inside the search
+        std::uint64_t _nodesPerRegion;
+        const RegionDatabase* _database;
+        std::uint64_t _budget = 0;
+        std::vector<TileContent> _tiles;
+        int _dim = 0;
+        std::vector<int> _queens;
+
+        Position positionOf(int square) const { return { square / _dim, square % _dim }; }
+        Position positionOf(const WindowRegion& window, int origin, int cell) const {
+            return positionOf(origin + (cell / window.cols) * _dim + cell % window.cols);
+        }
+
+        // The region cut out at its bounding box, if that is small enough for a database window
+        bool toWindow(const Region& region, WindowRegion& window, int& origin) const {
+            if (region.queens.size() > static_cast<std::size_t>(kMaxDatabaseQueens)) {
+                return false;
+            }
+            int minRow = _dim;
+            int minCol = _dim;
+            int maxRow = 0;
+            int maxCol = 0;
+            for (int square : region.squares) {
+                minRow = std::min(minRow, square / _dim);
+                maxRow = std::max(maxRow, square / _dim);
+                minCol = std::min(minCol, square % _dim);
+                maxCol = std::max(maxCol, square % _dim);
+            }
+            window.rows = maxRow - minRow + 1;
+            window.cols = maxCol - minCol + 1;
+            if (window.rows * window.cols > kMaxWindowCells) {
+                return false;
+            }
+
+            auto cellOf = [&](int square) { return (square / _dim - minRow) * window.cols + square % _dim - minCol; };
+            origin = minRow * _dim + minCol;
+            window.open = 0;
+            for (int square : region.squares) {
+                window.open |= static_cast<std::uint16_t>(1u << cellOf(square));
+            }
+            window.queenCount = static_cast<int>(region.queens.size());
+            for (int idx = 0; idx < window.queenCount; ++idx) {
+                window.queens[static_cast<std::size_t>(idx)] = cellOf(region.queens[static_cast<std::size_t>(idx)]);
+            }
+            return true;
+        }
+
+        int collectTargets(int square, int vacated, std::array<int, kMaxReachable>& targets) const {
+            int count = 0;
+            forEachReachableSquare(_tiles, _dim, square, vacated, [&](int target) { targets[static_cast<std::size_t>(count++)] = target; });
+            return count;
+        }
+
+        // Longest sequence of moves the region's queens can make. Stops early once every empty square
+        // is used up, which is the upper bound. 'exact' is cleared if the node budget cut the search.
+        int longestFill(int empty, std::uint64_t key, bool& exact, Move* firstMove) {
+            if (empty == 0) {
+                return 0;
+            }
+            if (!firstMove) {
+                auto it = _memo.find(key);
+                if (it != _memo.end()) {
+                    return it->second;
+                }
+            }
+
+            int best = 0;
+            bool complete = true;
+            std::array<int, kMaxReachable> steps{};
+            std::array<int, kMaxReachable> arrows{};
+            for (std::size_t queen = 0; queen < _queens.size() && best < empty && complete; ++queen) {
+                int from = _queens[queen];
+                TileContent queenTile = _tiles[static_cast<std::size_t>(from)];
+                int stepCount = collectTargets(from, -1, steps);
+                for (int step = 0; step < stepCount && best < empty && complete; ++step) {
+                    int to = steps[static_cast<std::size_t>(step)];
+                    _tiles[static_cast<std::size_t>(from)] = TileContent::Empty;
+                    _tiles[static_cast<std::size_t>(to)] = queenTile;
+                    _queens[queen] = to;
+
+                    // Shooting back into the square just left keeps the region whole, so it goes first
+                    int arrowCount = collectTargets(to, -1, arrows);
+                    std::swap(arrows[0], *std::find(arrows.begin(), arrows.begin() + arrowCount, from));
+                    for (int shot = 0; shot < arrowCount && best < empty; ++shot) {
+                        if (_budget == 0) {
+                            complete = false;
+                            break;
+                        }
+                        --_budget;
+                        int arrow = arrows[static_cast<std::size_t>(shot)];
+                        std::uint64_t childKey = key ^ queenKey(from) ^ emptyKey(from) ^ emptyKey(to) ^ queenKey(to) ^ emptyKey(arrow);
+                        _tiles[static_cast<std::size_t>(arrow)] = TileContent::Arrow;
+                        bool childExact = true;
+                        int value = 1 + longestFill(empty - 1, childKey, childExact, nullptr);
+                        _tiles[static_cast<std::size_t>(arrow)] = TileContent::Empty;
+                        complete = complete && childExact;
+                        if (value > best) {
+                            best = value;
+                            if (firstMove) {
+                                *firstMove = { Player::None, positionOf(from), positionOf(to), positionOf(arrow) };
+                            }
+                        }
+                    }
+
+                    _queens[queen] = from;
+                    _tiles[static_cast<std::size_t>(to)] = TileContent::Empty;
+                    _tiles[static_cast<std::size_t>(from)] = queenTile;
+                }
+            }
+
+            if (complete || best == empty) {
+                if (_memo.size() > (1u << 20)) {
+                    _memo.clear();
+                }
+                _memo[key] = static_cast<std::uint8_t>(best);
+                return best;
+            }
+            exact = false;
+            return best;
+        }
+    };
+}
@@ -61,6 +61,32 @@ inline PositionList gatherReachableTiles(const Board& board, const Position& sta
 	return reachable;
 }
 
+// Allocation-free counterpart of gatherReachableTiles for search code working on raw tiles:
+// calls visit(square) for every square a queen on 'square' reaches, 'vacated' (or -1) counts as empty
+template <typename Visit>
+void forEachReachableSquare(const std::vector<TileContent>& tiles, int dim, int square, int vacated, Visit visit) {
+	static constexpr std::array<std::pair<int, int>, 8> kDirections = {
+		std::pair{1, 0},  std::pair{-1, 0}, std::pair{0, 1},  std::pair{0, -1},
+		std::pair{1, 1},  std::pair{1, -1}, std::pair{-1, 1}, std::pair{-1, -1}
+	};
+
+	int startRow = square / dim;
+	int startCol = square % dim;
+	for (const auto& [dx, dy] : kDirections) {
+		int row = startRow + dx;
+		int col = startCol + dy;
+		while (row >= 0 && col >= 0 && row < dim && col < dim) {
+			int target = row * dim + col;
+			if (tiles[static_cast<std::size_t>(target)] != TileContent::Empty && target != vacated) {
+				break;
+			}
+			visit(target);
+			row += dx;
+			col += dy;
+		}
+	}
+}
+
 // Check if a list of positions contains a specific target
 inline bool containsPosition(const PositionList& positions, const Position& target) {
 	return std::any_of(positions.begin(), positions.end(),
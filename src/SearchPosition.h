@@ -0,0 +1,259 @@
+#pragma once
+
+#include "GameState.h"
+#include "IncrementalEval.h"
+#include "NeuralEval.h"
+#include "RegionMap.h"
+#include "Rules.h"
+#include "Symmetry.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+// Zobrist keys are generated at compile time, so hashes are identical across runs and builds
+namespace zobrist {
+
+    inline constexpr int kMaxSquares = 100;
+
+    constexpr std::uint64_t splitMix64(std::uint64_t& state) {
+        state += 0x9E3779B97F4A7C15ull;
+        std::uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    struct Keys {
+        std::array<std::array<std::uint64_t, kMaxSquares>, 3> tiles{}; // white queen, black queen, arrow
+        std::array<std::uint64_t, kMaxSquares> pendingArrow{};          // queen has moved, arrow not shot yet
+        std::array<std::uint64_t, 11> dimension{};
+        std::uint64_t blackToMove = 0;
+    };
+
+    constexpr Keys makeKeys() {
+        Keys keys;
+        std::uint64_t seed = 0x416D617A6F6E7321ull;
+        for (auto& table : keys.tiles) {
+            for (auto& key : table) {
+                key = splitMix64(seed);
+            }
+        }
+        for (auto& key : keys.pendingArrow) {
+            key = splitMix64(seed);
+        }
+        for (auto& key : keys.dimension) {
+            key = splitMix64(seed);
+        }
+        keys.blackToMove = splitMix64(seed);
+        return keys;
+    }
+
+    inline constexpr Keys kKeys = makeKeys();
+
+    inline std::uint64_t tileKey(TileContent tile, int square) {
+        switch (tile) {
+        case TileContent::WhiteQueen: return kKeys.tiles[0][static_cast<std::size_t>(square)];
+        case TileContent::BlackQueen: return kKeys.tiles[1][static_cast<std::size_t>(square)];
+        case TileContent::Arrow: return kKeys.tiles[2][static_cast<std::size_t>(square)];
+        default: return 0;
+        }
+    }
+
+    inline const std::array<std::uint64_t, kMaxSquares>& tileKeys(TileContent tile) {
+        return kKeys.tiles[static_cast<std::size_t>(tile) - 1];
+    }
+
+    inline std::uint64_t hashOf(const GameState& state) {
+        const auto& board = state.board();
+        int dim = board.dimension();
+        std::uint64_t hash = kKeys.dimension[static_cast<std::size_t>(dim)];
+        for (int square = 0; square < dim * dim; ++square) {
+            hash ^= tileKey(board.tiles()[static_cast<std::size_t>(square)], square);
+        }
+        if (state.currentPlayer() == Player::Black) {
+            hash ^= kKeys.blackToMove;
+        }
+        return hash;
+    }
+
+    // Hashes of the 8 symmetric images of a position; [0] is the plain hash
+    using SymmetricHashes = std::array<std::uint64_t, symmetry::kCount>;
+
+    inline SymmetricHashes symmetricHashesOf(const GameState& state) {
+        const auto& board = state.board();
+        int dim = board.dimension();
+        SymmetricHashes hashes;
+        hashes.fill(kKeys.dimension[static_cast<std::size_t>(dim)] ^ (state.currentPlayer() == Player::Black ? kKeys.blackToMove : 0));
+        for (int square = 0; square < dim * dim; ++square) {
+            TileContent tile = board.tiles()[static_cast<std::size_t>(square)];
+            if (tile == TileContent::Empty) {
+                continue;
+            }
+            for (int sym = 0; sym < symmetry::kCount; ++sym) {
+                hashes[static_cast<std::size_t>(sym)] ^= tileKey(tile, symmetry::apply(sym, dim, square));
+            }
+        }
+        return hashes;
+    }
+
+    // Key shared by all images of a position: the smallest image hash. 'sym' receives the symmetry
+    // that maps the position onto that image (the lowest one if several do).
+    inline std::uint64_t canonicalHash(const SymmetricHashes& hashes, int& sym) {
+        sym = 0;
+        for (int idx = 1; idx < symmetry::kCount; ++idx) {
+            if (hashes[static_cast<std::size_t>(idx)] < hashes[static_cast<std::size_t>(sym)]) {
+                sym = idx;
+            }
+        }
+        return hashes[static_cast<std::size_t>(sym)];
+    }
+
+    inline std::uint64_t canonicalHashOf(const GameState& state, int& sym) {
+        return canonicalHash(symmetricHashesOf(state), sym);
+    }
+}
+
+// GameState plus an incrementally updated Zobrist hash and LIFO make/unmake, so the search walks
+// the tree in place instead of cloning a GameState per node. A turn is made either whole or as two
+// half-moves (queen step, then arrow) for the half-move search. Positions that get evaluated also
+// keep the incremental evaluation terms, and the network accumulator if a network was loaded;
+// playouts, which only make moves, leave them out. The region map is kept on request.
+class SearchPosition {
+public:
+    explicit SearchPosition(const GameState& state, bool trackEvaluation = true, bool trackRegions = false)
+        : _state(state)
+        , _hashes(zobrist::symmetricHashesOf(state))
+    {
+        if (trackRegions) {
+            _regions.emplace(state.board());
+        }
+        if (trackEvaluation) {
+            _evaluation.emplace(state.board());
+            const auto& network = nnue::Network::instance();
+            if (network.isLoaded()) {
+                network.refresh(_accumulator.emplace(), state.board());
+            }
+        }
+    }
+
+    [[nodiscard]] const GameState& state() const { return _state; }
+    [[nodiscard]] const Board& board() const { return _state.board(); }
+    [[nodiscard]] int dimension() const { return _state.board().dimension(); }
+    [[nodiscard]] Player currentPlayer() const { return _state.currentPlayer(); }
+    [[nodiscard]] std::uint64_t hash() const { return _hashes[0]; }
+
+    // Hash shared with the position's mirror and rotation images, see zobrist::canonicalHash
+    [[nodiscard]] std::uint64_t canonicalHash(int& sym) const { return zobrist::canonicalHash(_hashes, sym); }
+
+    // Incremental evaluation terms, or nullptr if the position doesn't track them
+    [[nodiscard]] const IncrementalEval* evaluation() const { return _evaluation ? &*_evaluation : nullptr; }
+
+    // Network accumulator, or nullptr if the position doesn't track one
+    [[nodiscard]] const nnue::Accumulator* accumulator() const { return _accumulator ? &*_accumulator : nullptr; }
+
+    // Region map, or nullptr if the position doesn't track one
+    [[nodiscard]] const regions::RegionMap* regions() const { return _regions ? &*_regions : nullptr; }
+
+    // Queen that has stepped and still has to shoot (invalid between full turns)
+    [[nodiscard]] const Position& pendingShooter() const { return _pendingShooter; }
+
+    [[nodiscard]] int squareIndex(const Position& pos) const { return pos.row * dimension() + pos.col; }
+    [[nodiscard]] Position positionOf(int square) const { return { square / dimension(), square % dimension() }; }
+
+    // Hash after a whole move without making it (the pending-arrow keys of the two halves cancel)
+    [[nodiscard]] std::uint64_t hashAfter(const Move& move) const {
+        TileContent queenTile = tileForPlayer(_state.currentPlayer());
+        return _hashes[0] ^ zobrist::tileKey(queenTile, squareIndex(move.queenFrom)) ^ zobrist::tileKey(queenTile, squareIndex(move.queenTo))
+            ^ zobrist::tileKey(TileContent::Arrow, squareIndex(move.arrow)) ^ zobrist::kKeys.blackToMove;
+    }
+
+    void makeQueenStep(const Position& from, const Position& to) {
+        Player player = _state.currentPlayer();
+        const auto& queenKeys = zobrist::tileKeys(tileForPlayer(player));
+        _state.updateQueenPosition(player, from, to);
+        toggle(queenKeys, squareIndex(from));
+        toggle(queenKeys, squareIndex(to));
+        toggle(zobrist::kKeys.pendingArrow, squareIndex(to));
+        retile(squareIndex(from), tileForPlayer(player), TileContent::Empty);
+        retile(squareIndex(to), TileContent::Empty, tileForPlayer(player));
+        _pendingShooter = to;
+    }
+
+    void unmakeQueenStep(const Position& from, const Position& to) {
+        Player player = _state.currentPlayer();
+        const auto& queenKeys = zobrist::tileKeys(tileForPlayer(player));
+        _state.updateQueenPosition(player, to, from);
+        toggle(queenKeys, squareIndex(from));
+        toggle(queenKeys, squareIndex(to));
+        toggle(zobrist::kKeys.pendingArrow, squareIndex(to));
+        retile(squareIndex(to), tileForPlayer(player), TileContent::Empty);
+        retile(squareIndex(from), TileContent::Empty, tileForPlayer(player));
+        _pendingShooter = {};
+    }
+
+    // Completes the turn started by makeQueenStep
+    void makeArrow(const Position& arrow) {
+        _state.addArrow(arrow);
+        _state.setCurrentPlayer(opponentOf(_state.currentPlayer()));
+        toggle(zobrist::tileKeys(TileContent::Arrow), squareIndex(arrow));
+        toggle(zobrist::kKeys.pendingArrow, squareIndex(_pendingShooter));
+        toggleSideToMove();
+        retile(squareIndex(arrow), TileContent::Empty, TileContent::Arrow);
+        _pendingShooter = {};
+    }
+
+    void unmakeArrow(const Position& shooter, const Position& arrow) {
+        _state.setCurrentPlayer(opponentOf(_state.currentPlayer()));
+        _state.removeLastArrow();
+        _pendingShooter = shooter;
+        toggle(zobrist::tileKeys(TileContent::Arrow), squareIndex(arrow));
+        toggle(zobrist::kKeys.pendingArrow, squareIndex(shooter));
+        toggleSideToMove();
+        retile(squareIndex(arrow), TileContent::Arrow, TileContent::Empty);
+    }
+
+    void makeMove(const Move& move) {
+        makeQueenStep(move.queenFrom, move.queenTo);
+        makeArrow(move.arrow);
+    }
+
+    void unmakeMove(const Move& move) {
+        unmakeArrow(move.queenTo, move.arrow);
+        unmakeQueenStep(move.queenFrom, move.queenTo);
+    }
+
+private:
+    GameState _state;
+    zobrist::SymmetricHashes _hashes{};  // one per board symmetry, kept in step by every make/unmake
+    std::optional<IncrementalEval> _evaluation;
+    std::optional<nnue::Accumulator> _accumulator;
+    std::optional<regions::RegionMap> _regions;
+    Position _pendingShooter;
+
+    void toggle(const std::array<std::uint64_t, zobrist::kMaxSquares>& keys, int square) {
+        const auto& images = symmetry::kPermutations[static_cast<std::size_t>(dimension())].forward;
+        for (std::size_t sym = 0; sym < _hashes.size(); ++sym) {
+            _hashes[sym] ^= keys[images[sym][static_cast<std::size_t>(square)]];
+        }
+    }
+
+    // Keeps the tracked evaluation state in step with a tile change
+    void retile(int square, TileContent before, TileContent after) {
+        if (_evaluation) {
+            _evaluation->set(square, after);
+        }
+        if (_accumulator) {
+            nnue::Network::instance().update(*_accumulator, dimension(), square, before, after);
+        }
+        if (_regions) {
+            _regions->set(square, before, after);
+        }
+    }
+
+    void toggleSideToMove() {
+        for (auto& hash : _hashes) {
+            hash ^= zobrist::kKeys.blackToMove;
+        }
+    }
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Algorithms.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+// Engine state kept across the moves of one game. The transposition table, the evaluation cache
+// and the Monte Carlo tree survive between calls, so each search starts from what the previous
+// ones found: table entries and evaluations for positions below the new root, and the subtree of
+// the move actually played.
+// One search or ponder at a time; call reset() when the game changes.
+class SearchSession {
+public:
+    Move bestMove(const GameState& state, const SearchLimits& limits, Difficulty difficulty,
+        const std::atomic_bool* cancel = nullptr) {
+        auto searchStart = std::chrono::steady_clock::now();
+        SearchLimits searchLimits = limits;
+        Move instant = detail::instantMove(state, limits, cancel, searchLimits, searchStart);
+        if (instant.player != Player::None) {
+            return instant;
+        }
+
+        if (searchLimits.engine == SearchEngine::MonteCarlo) {
+            auto deadline = searchStart + searchLimits.timeBudget;
+            const mcts::SearchTree* previous = _expectedTree && _expectedTree->reaches(state) ? _expectedTree.get() : _tree.get();
+            _tree = previous ? std::make_unique<mcts::SearchTree>(*previous, state, searchLimits)
+                             : std::make_unique<mcts::SearchTree>(state, searchLimits);
+            _expectedTree.reset();
+            return mcts::runSearch(*_tree, searchLimits, deadline, cancel);
+        }
+
+        prepareTable(searchLimits);
+        return detail::searchAlphaBeta(state, searchLimits, difficulty, cancel, searchStart, *_table, _evalCache.get());
+    }
+
+    Move bestMove(const GameState& state, Difficulty difficulty, const std::atomic_bool* cancel = nullptr) {
+        return bestMove(state, searchLimitsForDifficulty(difficulty), difficulty, cancel);
+    }
+
+    // Thinks on the opponent's time, until 'stop' is set or a few move budgets have passed. The
+    // opponent's position 'state' is searched as if it were ours to predict their reply, then the
+    // position after that reply for as long as they think. If the prediction comes true, the next
+    // bestMove() starts from that search (the Monte Carlo subtree or the table entries) and is
+    // quick to finish; otherwise it still has the first search, which covered every reply.
+    void ponder(const GameState& state, const SearchLimits& limits, Difficulty difficulty, const std::atomic_bool& stop) {
+        _expectedTree.reset();
+        try {
+            auto predictionStart = std::chrono::steady_clock::now();
+            Move expected;
+            if (limits.engine == SearchEngine::MonteCarlo) {
+                _tree = _tree ? std::make_unique<mcts::SearchTree>(*_tree, state, limits)
+                              : std::make_unique<mcts::SearchTree>(state, limits);
+                expected = mcts::runSearch(*_tree, limits, predictionStart + limits.timeBudget, &stop);
+            }
+            else {
+                prepareTable(limits);
+                expected = detail::searchAlphaBeta(state, limits, difficulty, &stop, predictionStart, *_table, _evalCache.get());
+            }
+            if (expected.player == Player::None || stop.load()) {
+                return;
+            }
+
+            GameState reply = state;
+            applyMove(reply, expected);
+            if (reply.isFinished()) {
+                return;
+            }
+            SearchLimits ponderLimits = limits;
+            ponderLimits.timeBudget = limits.timeBudget * kPonderBudgets;
+            auto ponderStart = std::chrono::steady_clock::now();
+            if (limits.engine == SearchEngine::MonteCarlo) {
+                _expectedTree = std::make_unique<mcts::SearchTree>(*_tree, reply, ponderLimits);
+                mcts::runSearch(*_expectedTree, ponderLimits, ponderStart + ponderLimits.timeBudget, &stop);
+            }
+            else {
+                _table->newSearch();
+                detail::searchAlphaBeta(reply, ponderLimits, difficulty, &stop, ponderStart, *_table, _evalCache.get());
+            }
+        }
+        catch (const SearchCanceled&) {
+            // The opponent moved; what was found stays in the table or trees
+        }
+    }
+
+    // Evaluation cache counters since the cache was made, all zero before the first alpha-beta search
+    [[nodiscard]] EvalCache::Stats evalCacheStats() const { return _evalCache ? _evalCache->stats() : EvalCache::Stats{}; }
+
+    void reset() {
+        _table.reset();
+        _tableMegabytes = 0;
+        _evalCache.reset();
+        _evalCacheMegabytes = 0;
+        _tree.reset();
+        _expectedTree.reset();
+    }
+
+private:
+    static constexpr int kPonderBudgets = 10;  // cap: pondering past ten move budgets rarely pays
+
+    std::unique_ptr<TranspositionTable> _table;
+    std::size_t _tableMegabytes = 0;
+    std::unique_ptr<EvalCache> _evalCache;  // cached evaluations stay valid for the whole game
+    std::size_t _evalCacheMegabytes = 0;
+    std::unique_ptr<mcts::SearchTree> _tree;
+    std::unique_ptr<mcts::SearchTree> _expectedTree;  // pondered position after the predicted reply
+
+    void prepareTable(const SearchLimits& limits) {
+        if (!_table || _tableMegabytes != limits.tableMegabytes) {
+            _table = std::make_unique<TranspositionTable>(limits.tableMegabytes);
+            _tableMegabytes = limits.tableMegabytes;
+        }
+        else {
+            _table->newSearch();
+        }
+        if (_evalCacheMegabytes != limits.evalCacheMegabytes) {
+            _evalCache = limits.evalCacheMegabytes > 0 ? std::make_unique<EvalCache>(limits.evalCacheMegabytes) : nullptr;
+            _evalCacheMegabytes = limits.evalCacheMegabytes;
+        }
+    }
+};
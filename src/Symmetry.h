@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// The 8 symmetries of the square board (rotations and reflections). The rules don't depend on
+// orientation, so positions that are images of each other have the same value, and the best move
+// of one is the image of the best move of the other.
+namespace symmetry {
+
+    inline constexpr int kCount = 8;
+    inline constexpr int kMaxDimension = 10;
+
+    // Image of a square under symmetry 'sym': bit 0 mirrors the columns, bit 1 the rows, and bit 2
+    // then swaps rows and columns. Symmetry 0 is the identity.
+    constexpr int transform(int sym, int dim, int square) {
+        int row = square / dim;
+        int col = square % dim;
+        if (sym & 1) {
+            col = dim - 1 - col;
+        }
+        if (sym & 2) {
+            row = dim - 1 - row;
+        }
+        if (sym & 4) {
+            int swapped = row;
+            row = col;
+            col = swapped;
+        }
+        return row * dim + col;
+    }
+
+    // Square permutations of one board dimension; inverse[sym] undoes forward[sym]
+    struct Permutations {
+        std::array<std::array<std::uint8_t, kMaxDimension * kMaxDimension>, kCount> forward{};
+        std::array<std::array<std::uint8_t, kMaxDimension * kMaxDimension>, kCount> inverse{};
+    };
+
+    constexpr std::array<Permutations, kMaxDimension + 1> makePermutations() {
+        std::array<Permutations, kMaxDimension + 1> tables{};
+        for (int dim = 1; dim <= kMaxDimension; ++dim) {
+            auto& table = tables[static_cast<std::size_t>(dim)];
+            for (int sym = 0; sym < kCount; ++sym) {
+                for (int square = 0; square < dim * dim; ++square) {
+                    int image = transform(sym, dim, square);
+                    table.forward[static_cast<std::size_t>(sym)][static_cast<std::size_t>(square)] = static_cast<std::uint8_t>(image);
+                    table.inverse[static_cast<std::size_t>(sym)][static_cast<std::size_t>(image)] = static_cast<std::uint8_t>(square);
+                }
+            }
+        }
+        return tables;
+    }
+
+    inline constexpr std::array<Permutations, kMaxDimension + 1> kPermutations = makePermutations();
+
+    inline int apply(int sym, int dim, int square) {
+        return kPermutations[static_cast<std::size_t>(dim)].forward[static_cast<std::size_t>(sym)][static_cast<std::size_t>(square)];
+    }
+
+    inline int undo(int sym, int dim, int square) {
+        return kPermutations[static_cast<std::size_t>(dim)].inverse[static_cast<std::size_t>(sym)][static_cast<std::size_t>(square)];
+    }
+}
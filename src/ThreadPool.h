@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads for data-parallel search work. run() hands out task indices
+// [0, count) to the pool threads and the calling thread and blocks until every task is done.
+// Worker id 0 is always the calling thread, pool threads are 1..workerCount().
+class ThreadPool {
+public:
+    using Task = std::function<void(std::size_t task, unsigned worker)>;
+
+    explicit ThreadPool(unsigned workers) {
+        for (unsigned id = 1; id <= workers; ++id) {
+            _threads.emplace_back([this, id]() { workerLoop(id); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] unsigned workerCount() const { return static_cast<unsigned>(_threads.size()); }
+
+    // Runs 'task' for every index in [0, count) on at most 'maxParticipants' threads (caller
+    // included). The first exception thrown by a task is rethrown here once all tasks finished.
+    // Calls from different threads are serialised; a task must not call run() itself.
+    void run(std::size_t count, const Task& task, unsigned maxParticipants) {
+        if (count == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> runLock(_runMutex);
+
+        unsigned helpers = std::min(workerCount(), std::max(1u, maxParticipants) - 1);
+        helpers = static_cast<unsigned>(std::min<std::size_t>(helpers, count - 1));
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _task = &task;
+            _count = count;
+            _next.store(0);
+            _helpersWanted = helpers;
+            _helpersActive = helpers;
+            _error = nullptr;
+            ++_generation;
+        }
+        _wake.notify_all();
+
+        work(0);
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _done.wait(lock, [this]() { return _helpersActive == 0; });
+            _task = nullptr;
+            error = _error;
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Process-wide pool sized to the hardware, created on first use
+    static ThreadPool& shared() {
+        static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
+private:
+    std::vector<std::thread> _threads;
+    std::mutex _runMutex;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const Task* _task = nullptr;
+    std::size_t _count = 0;
+    std::atomic<std::size_t> _next{ 0 };
+    unsigned _helpersWanted = 0;
+    unsigned _helpersActive = 0;
+    std::uint64_t _generation = 0;
+    std::exception_ptr _error;
+    bool _stopping = false;
+
+    void work(unsigned worker) {
+        while (true) {
+            std::size_t idx = _next.fetch_add(1);
+            if (idx >= _count) {
+                return;
+            }
+            try {
+                (*_task)(idx, worker);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_error) {
+                    _error = std::current_exception();
+                }
+            }
+        }
+    }
+
+    void workerLoop(unsigned id) {
+        std::uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [&]() { return _stopping || _generation != seen; });
+                if (_stopping) {
+                    return;
+                }
+                seen = _generation;
+                if (id > _helpersWanted) {
+                    continue;
+                }
+            }
+
+            work(id);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_helpersActive == 0) {
+                _done.notify_all();
+            }
+        }
+    }
+};
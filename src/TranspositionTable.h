@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum class Bound : std::uint8_t {
+    None = 0,
+    Exact,
+    Lower,  // value >= score (search failed high)
+    Upper   // value <= score (search failed low)
+};
+
+// Best move hint stored with an entry as square indices. A queen-ply entry fills from/to only,
+// an arrow-ply entry fills arrow only, an atomic-move entry fills all three.
+struct TableMove {
+    static constexpr std::uint8_t kNone = 0x7F;
+
+    std::uint8_t from = kNone;
+    std::uint8_t to = kNone;
+    std::uint8_t arrow = kNone;
+};
+
+struct TableEntry {
+    int score = 0;
+    int depth = -1;
+    Bound bound = Bound::None;
+    TableMove move;
+};
+
+// Fixed-size hash table of search results, shared lock-free by all search threads.
+// Two slots per bucket: one depth-preferred, one always-replace. Each slot stores
+// (key ^ data, data) in two relaxed atomics; a reader that sees halves from two different
+// writes gets a key mismatch and treats the slot as empty, so torn entries are never used.
+// Payload is packed into 64 bits: score (32), depth (6), generation (2), bound (2), move (3x7).
+// A table kept across searches calls newSearch() before each one; deep entries left by earlier
+// searches then give way in the depth-preferred slot, since their positions rarely come back.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(std::size_t megabytes = 16) {
+        resize(megabytes);
+    }
+
+    // Not thread-safe: only call while no search is running
+    void resize(std::size_t megabytes) {
+        std::size_t buckets = 1;
+        while (buckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+            buckets *= 2;
+        }
+        _buckets = std::make_unique<Bucket[]>(buckets);
+        _bucketCount = buckets;
+        clear();
+    }
+
+    void clear() {
+        for (std::size_t idx = 0; idx < _bucketCount; ++idx) {
+            for (auto& slot : _buckets[idx].slots) {
+                slot.check.store(0, std::memory_order_relaxed);
+                slot.data.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Not thread-safe: only call while no search is running
+    void newSearch() {
+        _generation = (_generation + 1) & kGenerationMask;
+    }
+
+    bool probe(std::uint64_t key, TableEntry& entry) const {
+        const auto& bucket = _buckets[key & (_bucketCount - 1)];
+        for (const auto& slot : bucket.slots) {
+            std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+            std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+            if (data != 0 && (check ^ data) == key) {
+                entry = unpack(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void store(std::uint64_t key, int depth, int score, Bound bound, const TableMove& move) {
+        auto& bucket = _buckets[key & (_bucketCount - 1)];
+        std::uint64_t data = pack(depth, score, bound, move, _generation);
+        auto& deepSlot = bucket.slots[0];
+        std::uint64_t deepData = deepSlot.data.load(std::memory_order_relaxed);
+        std::uint64_t deepKey = deepSlot.check.load(std::memory_order_relaxed) ^ deepData;
+        bool replaceDeep = deepData == 0 || deepKey == key || generationOf(deepData) != _generation
+            || depth >= unpack(deepData).depth;
+        write(replaceDeep ? deepSlot : bucket.slots[1], key, data);
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> check{ 0 };
+        std::atomic<std::uint64_t> data{ 0 };
+    };
+
+    struct Bucket {
+        Slot slots[2];
+    };
+
+    static constexpr std::uint8_t kMaxStoredDepth = 62;
+    static constexpr std::uint8_t kGenerationMask = 0x3;
+
+    std::unique_ptr<Bucket[]> _buckets;
+    std::size_t _bucketCount = 0;
+    std::uint8_t _generation = 0;
+
+    static void write(Slot& slot, std::uint64_t key, std::uint64_t data) {
+        slot.check.store(key ^ data, std::memory_order_relaxed);
+        slot.data.store(data, std::memory_order_relaxed);
+    }
+
+    static std::uint64_t pack(int depth, int score, Bound bound, const TableMove& move, std::uint8_t generation) {
+        std::uint64_t data = static_cast<std::uint32_t>(score);
+        data |= static_cast<std::uint64_t>(std::clamp(depth, -1, static_cast<int>(kMaxStoredDepth)) + 1) << 32;
+        data |= static_cast<std::uint64_t>(generation & kGenerationMask) << 38;
+        data |= static_cast<std::uint64_t>(bound) << 40;
+        data |= static_cast<std::uint64_t>(move.from & 0x7F) << 42;
+        data |= static_cast<std::uint64_t>(move.to & 0x7F) << 49;
+        data |= static_cast<std::uint64_t>(move.arrow & 0x7F) << 56;
+        return data;
+    }
+
+    static std::uint8_t generationOf(std::uint64_t data) {
+        return static_cast<std::uint8_t>((data >> 38) & kGenerationMask);
+    }
+
+    static TableEntry unpack(std::uint64_t data) {
+        TableEntry entry;
+        entry.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data & 0xFFFFFFFFull));
+        entry.depth = static_cast<int>((data >> 32) & 0x3F) - 1;
+        entry.bound = static_cast<Bound>((data >> 40) & 0x3);
+        entry.move.from = static_cast<std::uint8_t>((data >> 42) & 0x7F);
+        entry.move.to = static_cast<std::uint8_t>((data >> 49) & 0x7F);
+        entry.move.arrow = static_cast<std::uint8_t>((data >> 56) & 0x7F);
+        return entry;
+    }
+};
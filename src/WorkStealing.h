@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thrown inside a split search when this or an enclosing split point has been cut off;
+// the result of the interrupted subtree is simply discarded.
+struct SplitCutoff : public std::exception {
+    const char* what() const noexcept override {
+        return "split point cut off";
+    }
+};
+
+// Younger brothers of a node, offered for parallel search once the eldest brother is done.
+// Jobs [first, count) are claimed one at a time by the owner and by any worker that joined.
+// A cutoff (beta cutoff in a sibling, an error, or a cutoff in any enclosing split point)
+// stops further claims and is visible to every search running below this split point.
+class SplitPoint {
+public:
+    using Job = std::function<void(std::size_t index, unsigned worker)>;
+
+    SplitPoint(const SplitPoint* parent, std::size_t first, std::size_t count, Job job)
+        : _parent(parent)
+        , _next(first)
+        , _count(count)
+        , _job(std::move(job))
+    {
+    }
+
+    SplitPoint(const SplitPoint&) = delete;
+    SplitPoint& operator=(const SplitPoint&) = delete;
+
+    [[nodiscard]] bool cutoff() const {
+        for (const SplitPoint* split = this; split; split = split->_parent) {
+            if (split->_cutoff.load(std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void signalCutoff() { _cutoff.store(true, std::memory_order_relaxed); }
+
+    // True if 'ancestor' encloses this split point (a split point doesn't enclose itself)
+    [[nodiscard]] bool descendsFrom(const SplitPoint* ancestor) const {
+        for (const SplitPoint* split = _parent; split; split = split->_parent) {
+            if (split == ancestor) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Registers a helper if there is still work; called with the owner's deque locked
+    bool tryJoin() {
+        if (cutoff() || _next.load() >= _count) {
+            return false;
+        }
+        _helpers.fetch_add(1);
+        return true;
+    }
+
+    // Unregisters a helper; true if it was the last one. The owner may return (and destroy the
+    // split point) as soon as the count is zero.
+    bool leave() { return _helpers.fetch_sub(1) == 1; }
+
+    [[nodiscard]] int helpers() const { return _helpers.load(); }
+
+    // Runs jobs until none are left or the split point is cut off
+    void work(unsigned worker) {
+        while (!cutoff()) {
+            std::size_t idx = _next.fetch_add(1);
+            if (idx >= _count) {
+                return;
+            }
+            try {
+                _job(idx, worker);
+            }
+            catch (const SplitCutoff&) {
+                // Interrupted by a cutoff at this level or above
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(_errorMutex);
+                if (!_error) {
+                    _error = std::current_exception();
+                }
+                signalCutoff();
+            }
+        }
+    }
+
+    [[nodiscard]] std::exception_ptr error() const {
+        std::lock_guard<std::mutex> lock(_errorMutex);
+        return _error;
+    }
+
+private:
+    const SplitPoint* _parent;
+    std::atomic<std::size_t> _next;
+    std::size_t _count;
+    Job _job;
+    std::atomic_bool _cutoff{ false };
+    std::atomic<int> _helpers{ 0 };
+    mutable std::mutex _errorMutex;
+    std::exception_ptr _error;
+};
+
+// Young Brothers Wait scheduler for one search. Every worker owns a deque of the split points
+// it has opened, newest at the back; idle workers steal from the front of the other deques, which
+// holds the oldest and therefore largest pieces of work. Worker 0 is the thread that created
+// the scheduler, workers 1..N-1 are started here and sleep until a split point is published.
+class WorkStealingScheduler {
+public:
+    explicit WorkStealingScheduler(unsigned workers)
+        : _queues(std::max(1u, workers))
+    {
+        for (unsigned id = 1; id < _queues.size(); ++id) {
+            _threads.emplace_back([this, id]() {
+                while (!_stopping.load()) {
+                    std::uint64_t seen = events();
+                    if (!helpOnce(id, nullptr)) {
+                        waitForEvent(seen);
+                    }
+                }
+            });
+        }
+    }
+
+    ~WorkStealingScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(_idleMutex);
+            _stopping.store(true);
+        }
+        _idle.notify_all();
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    // Offers the split point to the other workers, works on it, then waits until every helper
+    // has left. While waiting it only helps with split points its helpers opened below this one
+    // (the "helpful master"), so it is never caught in unrelated work once its own is done.
+    // The first error raised by any job is rethrown here.
+    void runSplit(unsigned worker, SplitPoint& split) {
+        auto& queue = _queues[worker];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.splits.push_back(&split);
+        }
+        signalEvent();
+
+        split.work(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.splits.erase(std::find(queue.splits.begin(), queue.splits.end(), &split));
+        }
+        while (split.helpers() > 0) {
+            std::uint64_t seen = events();
+            if (!helpOnce(worker, &split) && split.helpers() > 0) {
+                waitForEvent(seen);
+            }
+        }
+
+        if (auto error = split.error()) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<SplitPoint*> splits;
+    };
+
+    std::vector<WorkQueue> _queues;
+    std::vector<std::thread> _threads;
+    std::atomic_bool _stopping{ false };
+
+    // Idle workers and waiting owners sleep until the event count moves on: a split point was
+    // published or the last helper left one
+    std::mutex _idleMutex;
+    std::condition_variable _idle;
+    std::uint64_t _events = 0;
+    int _sleepers = 0;
+
+    std::uint64_t events() {
+        std::lock_guard<std::mutex> lock(_idleMutex);
+        return _events;
+    }
+
+    void signalEvent() {
+        std::lock_guard<std::mutex> lock(_idleMutex);
+        ++_events;
+        if (_sleepers > 0) {
+            _idle.notify_all();
+        }
+    }
+
+    // Sleeps unless an event happened since 'seen' was read
+    void waitForEvent(std::uint64_t seen) {
+        std::unique_lock<std::mutex> lock(_idleMutex);
+        ++_sleepers;
+        _idle.wait(lock, [&]() { return _events != seen || _stopping.load(); });
+        --_sleepers;
+    }
+
+    // Joins the oldest split point with work left in another worker's deque; with 'within' set,
+    // only split points below it
+    bool helpOnce(unsigned worker, const SplitPoint* within) {
+        std::size_t queueCount = _queues.size();
+        for (std::size_t offset = 1; offset < queueCount; ++offset) {
+            auto& victim = _queues[(worker + offset) % queueCount];
+            SplitPoint* stolen = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                for (auto* split : victim.splits) {
+                    if ((!within || split->descendsFrom(within)) && split->tryJoin()) {
+                        stolen = split;
+                        break;
+                    }
+                }
+            }
+            if (stolen) {
+                stolen->work(worker);
+                if (stolen->leave()) {
+                    signalEvent();  // its owner may be waiting for us
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,104 @@
+// Offline opening book builder: headless self-play with the Monte Carlo engine on every board size.
+// Each position of the first plies is searched; its most visited root moves become book candidates
+// weighted by visits, and the game continues with one of them drawn by weight so the lines fan out.
+// Usage: BookGen [output path] [plies] [games per board size] [ms per move] [threads]
+#include "Algorithms.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+    constexpr std::size_t kCandidates = 4;  // book moves kept per position
+    constexpr std::uint32_t kMinShare = 8;  // candidates need 1/8 of the best move's visits
+
+    using MoveKey = std::tuple<std::uint64_t, std::uint8_t, std::uint8_t, std::uint8_t>;
+}
+
+int main(int argc, const char** argv) {
+    const char* path = argc > 1 ? argv[1] : "opening.book";
+    int plies = argc > 2 ? std::atoi(argv[2]) : 8;
+    int gamesPerSize = argc > 3 ? std::atoi(argv[3]) : 64;
+    auto budget = std::chrono::milliseconds(argc > 4 ? std::atoi(argv[4]) : 1000);
+    unsigned threads = std::max(1u, argc > 5 ? static_cast<unsigned>(std::atoi(argv[5])) : std::thread::hardware_concurrency());
+
+    std::map<MoveKey, std::uint64_t> weights;
+    std::mutex weightsMutex;
+    std::atomic<int> nextGame{ 0 };
+    int totalGames = gamesPerSize * static_cast<int>(kBoardSizeConfigs.size());
+
+    auto worker = [&](unsigned id) {
+        std::mt19937 rng(0xB00Cu + id);
+        SearchLimits limits = searchLimitsForDifficulty(Difficulty::Hard);
+        limits.threads = 1;
+        limits.timeBudget = budget;
+
+        for (int game = nextGame++; game < totalGames; game = nextGame++) {
+            GameState state;
+            state.startNewGame(kBoardSizeConfigs[static_cast<std::size_t>(game) % kBoardSizeConfigs.size()].id, Difficulty::Hard);
+            int dim = state.board().dimension();
+
+            for (int ply = 0; ply < plies && !state.isFinished(); ++ply) {
+                mcts::SearchTree tree(state, limits);
+                tree.search(0, std::chrono::steady_clock::now() + budget, nullptr);
+                auto children = tree.rootChildren();
+                if (children.empty()) {
+                    break;
+                }
+                std::uint32_t threshold = children.front().visits / kMinShare;
+                children.erase(std::remove_if(children.begin(), children.end(),
+                    [threshold](const auto& child) { return child.visits < threshold; }), children.end());
+                if (children.size() > kCandidates) {
+                    children.resize(kCandidates);
+                }
+
+                std::vector<double> odds;
+                {
+                    // Entries are canonical, so mirror and rotation images of a position pool their weights
+                    std::lock_guard<std::mutex> lock(weightsMutex);
+                    for (const auto& child : children) {
+                        BookEntry entry = OpeningBook::entryFor(state, child.move, 0);
+                        weights[{ entry.key, entry.from, entry.to, entry.arrow }] += child.visits;
+                        odds.push_back(child.visits);
+                    }
+                }
+
+                std::discrete_distribution<std::size_t> draw(odds.begin(), odds.end());
+                applyMove(state, children[draw(rng)].move);
+            }
+            std::printf("game %d/%d done (%dx%d)\n", game + 1, totalGames, dim, dim);
+            std::fflush(stdout);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned id = 1; id < threads; ++id) {
+        pool.emplace_back(worker, id);
+    }
+    worker(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    std::vector<BookEntry> entries;
+    for (const auto& [moveKey, weight] : weights) {
+        BookEntry entry;
+        std::tie(entry.key, entry.from, entry.to, entry.arrow) = moveKey;
+        entry.weight = static_cast<std::uint32_t>(std::min<std::uint64_t>(weight, UINT32_MAX));
+        entries.push_back(entry);
+    }
+    if (!OpeningBook::write(path, entries)) {
+        std::fprintf(stderr, "Could not write %s\n", path);
+        return 1;
+    }
+    std::printf("Wrote %zu book moves to %s\n", entries.size(), path);
+    return 0;
+}
@@ -0,0 +1,855 @@
+// Checks the engine's fast paths against plain recomputation, on positions from random games on
+// every board size, and times both. Exits with 1 if any check finds a difference.
+// Usage: EngineCheck [check] [games per board size]
+// Checks: distance, territory, incremental, centrality, symmetry, cache, splitpoints, depth, settled,
+// prover, regions, batch, network (all of them if none is given). Built with -fsanitize=thread,
+// splitpoints looks for data races. depth only times: how long Hard alpha-beta takes to finish each
+// depth on 10x10; prover only counts how often Hard's endgame prover succeeds once it starts.
+#include "SearchSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+    // Positions after a random number of random turns, 'games' per board size
+    std::vector<GameState> randomPositions(int games, std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<GameState> positions;
+        for (const auto& config : kBoardSizeConfigs) {
+            for (int game = 0; game < games; ++game) {
+                GameState state;
+                state.startNewGame(config.id, Difficulty::Hard);
+                int turns = static_cast<int>(rng() % static_cast<unsigned>(config.dimension * config.dimension));
+                for (int turn = 0; turn < turns && !state.isFinished(); ++turn) {
+                    auto moves = generateMovesForPlayer(state, state.currentPlayer());
+                    if (moves.empty()) {
+                        break;
+                    }
+                    applyMove(state, moves[rng() % moves.size()]);
+                }
+                positions.push_back(std::move(state));
+            }
+        }
+        return positions;
+    }
+
+    // Random make/unmake walk of 'steps' turns per board size, some made as a queen step and an
+    // arrow; 'check' sees the position after every change. Returns how many positions it saw.
+    template <typename Check>
+    int randomWalk(int steps, std::uint32_t seed, bool trackRegions, Check check) {
+        std::mt19937 rng(seed);
+        int seen = 0;
+        for (const auto& config : kBoardSizeConfigs) {
+            GameState start;
+            start.startNewGame(config.id, Difficulty::Hard);
+            SearchPosition position(start, true, trackRegions);
+            std::vector<Move> played;
+            for (int step = 0; step < steps; ++step) {
+                auto moves = generateMovesForPlayer(position.state(), position.currentPlayer());
+                if (moves.empty() || (!played.empty() && rng() % 4 == 0)) {
+                    if (played.empty()) {
+                        break;
+                    }
+                    position.unmakeMove(played.back());
+                    played.pop_back();
+                }
+                else {
+                    Move move = moves[rng() % moves.size()];
+                    if (rng() % 3 == 0) {
+                        position.makeQueenStep(move.queenFrom, move.queenTo);
+                        check(position);
+                        ++seen;
+                        position.makeArrow(move.arrow);
+                    }
+                    else {
+                        position.makeMove(move);
+                    }
+                    played.push_back(move);
+                }
+                check(position);
+                ++seen;
+            }
+        }
+        return seen;
+    }
+
+    // Microseconds per position of 'run' over 'positions'
+    template <typename Run>
+    double microseconds(const std::vector<GameState>& positions, Run run) {
+        constexpr int kRepeats = 20;
+        auto start = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < kRepeats; ++repeat) {
+            for (const auto& state : positions) {
+                run(state);
+            }
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (kRepeats * static_cast<double>(positions.size()));
+    }
+
+    // Reference for distance::fill: a square by square BFS from all queens on 'queen' tiles
+    distance::Map plainDistances(const std::vector<TileContent>& tiles, int dim, TileContent queen, distance::Metric metric) {
+        distance::Map distances;
+        distances.fill(distance::kUnreached);
+        std::vector<int> frontier;
+        for (int square = 0; square < dim * dim; ++square) {
+            if (tiles[static_cast<std::size_t>(square)] == queen) {
+                frontier.push_back(square);
+            }
+        }
+        auto reach = [&](int target, std::uint8_t steps, std::vector<int>& next) {
+            if (distances[static_cast<std::size_t>(target)] == distance::kUnreached) {
+                distances[static_cast<std::size_t>(target)] = steps;
+                next.push_back(target);
+            }
+        };
+        for (std::uint8_t steps = 1; !frontier.empty(); ++steps) {
+            std::vector<int> next;
+            for (int square : frontier) {
+                if (metric == distance::Metric::Queen) {
+                    forEachReachableSquare(tiles, dim, square, -1, [&](int target) { reach(target, steps, next); });
+                    continue;
+                }
+                for (int row = std::max(0, square / dim - 1); row <= std::min(dim - 1, square / dim + 1); ++row) {
+                    for (int col = std::max(0, square % dim - 1); col <= std::min(dim - 1, square % dim + 1); ++col) {
+                        if (tiles[static_cast<std::size_t>(row * dim + col)] == TileContent::Empty) {
+                            reach(row * dim + col, steps, next);
+                        }
+                    }
+                }
+            }
+            frontier = std::move(next);
+        }
+        return distances;
+    }
+
+    // Reference for regions::findRegions: a flood fill from every queen, compared as a set
+    auto plainRegions(const Board& board) {
+        int dim = board.dimension();
+        const auto& tiles = board.tiles();
+        std::vector<bool> seen(tiles.size(), false);
+        std::vector<std::tuple<Player, bool, int, std::vector<int>>> found;
+        for (int start = 0; start < dim * dim; ++start) {
+            if (seen[static_cast<std::size_t>(start)] || !isQueen(tiles[static_cast<std::size_t>(start)])) {
+                continue;
+            }
+            Player owner = Player::None;
+            bool contested = false;
+            int empty = 0;
+            std::vector<int> squares{ start };
+            seen[static_cast<std::size_t>(start)] = true;
+            for (std::size_t head = 0; head < squares.size(); ++head) {
+                int square = squares[head];
+                TileContent tile = tiles[static_cast<std::size_t>(square)];
+                if (isQueen(tile)) {
+                    Player player = tile == TileContent::WhiteQueen ? Player::White : Player::Black;
+                    contested = contested || (owner != Player::None && owner != player);
+                    owner = player;
+                }
+                else {
+                    ++empty;
+                }
+                for (int row = std::max(0, square / dim - 1); row <= std::min(dim - 1, square / dim + 1); ++row) {
+                    for (int col = std::max(0, square % dim - 1); col <= std::min(dim - 1, square % dim + 1); ++col) {
+                        auto next = static_cast<std::size_t>(row * dim + col);
+                        if (!seen[next] && tiles[next] != TileContent::Arrow) {
+                            seen[next] = true;
+                            squares.push_back(row * dim + col);
+                        }
+                    }
+                }
+            }
+            std::sort(squares.begin(), squares.end());
+            found.emplace_back(contested ? Player::None : owner, contested, empty, std::move(squares));
+        }
+        std::sort(found.begin(), found.end());
+        return found;
+    }
+
+    // distance::fill against the square by square BFS, and regions::findRegions (which grows
+    // regions with distance::connected) against a flood fill
+    bool checkDistance(int games) {
+        auto positions = randomPositions(games, 3);
+        int wrongMaps = 0;
+        int wrongRegions = 0;
+        for (const auto& state : positions) {
+            const auto& tiles = state.board().tiles();
+            int dim = state.board().dimension();
+            distance::Occupancy occupancy(tiles, dim);
+            for (auto metric : { distance::Metric::Queen, distance::Metric::King }) {
+                distance::SideMaps maps;
+                distance::fill(occupancy, metric, maps);
+                wrongMaps += maps.white != plainDistances(tiles, dim, TileContent::WhiteQueen, metric)
+                    || maps.black != plainDistances(tiles, dim, TileContent::BlackQueen, metric);
+            }
+
+            std::vector<std::tuple<Player, bool, int, std::vector<int>>> found;
+            for (const auto& region : regions::findRegions(state.board())) {
+                auto squares = region.squares;
+                std::sort(squares.begin(), squares.end());
+                found.emplace_back(region.owner, region.contested, region.emptySquares, std::move(squares));
+            }
+            std::sort(found.begin(), found.end());
+            wrongRegions += found != plainRegions(state.board());
+        }
+        std::printf("distance: %zu positions, %d wrong distance maps, %d wrong region sets\n", positions.size(), wrongMaps,
+            wrongRegions);
+
+        double kernel = microseconds(positions, [](const GameState& state) {
+            distance::Occupancy occupancy(state.board().tiles(), state.board().dimension());
+            distance::SideMaps queen, king;
+            distance::fill(occupancy, distance::Metric::Queen, queen);
+            distance::fill(occupancy, distance::Metric::King, king);
+        });
+        double plain = microseconds(positions, [](const GameState& state) {
+            const auto& tiles = state.board().tiles();
+            int dim = state.board().dimension();
+            for (auto queen : { TileContent::WhiteQueen, TileContent::BlackQueen }) {
+                plainDistances(tiles, dim, queen, distance::Metric::Queen);
+                plainDistances(tiles, dim, queen, distance::Metric::King);
+            }
+        });
+        std::printf("distance: four maps in %.2f us, %.2f us square by square\n", kernel, plain);
+        return wrongMaps == 0 && wrongRegions == 0;
+    }
+
+    // detail::territoryScore must be the same from both sides with the sign flipped: every term
+    // compares the two sides' distances, and a tie leans towards the side to move, not the viewer
+    bool checkTerritory(int games) {
+        auto positions = randomPositions(games, 5);
+        int asymmetric = 0;
+        for (const auto& state : positions) {
+            asymmetric += detail::territoryScore(state, Player::White) != -detail::territoryScore(state, Player::Black);
+        }
+        std::printf("territory: %zu positions, %d scores that differ between the sides\n", positions.size(), asymmetric);
+
+        int sink = 0;
+        double perCall = microseconds(positions, [&](const GameState& state) { sink += detail::territoryScore(state, Player::White); });
+        std::printf("territory: %.2f us per call (%d)\n", perCall, sink & 1);
+        return asymmetric == 0;
+    }
+
+    bool sameTerms(const IncrementalEval& kept, const IncrementalEval& fresh, int dim) {
+        for (Player player : { Player::White, Player::Black }) {
+            if (kept.mobility(player) != fresh.mobility(player) || kept.centrality(player) != fresh.centrality(player)) {
+                return false;
+            }
+            for (int square = 0; square < dim * dim; ++square) {
+                if (kept.reachers(player, square) != fresh.reachers(player, square)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // The terms SearchPosition keeps up to date on make/unmake against terms built from the board,
+    // and evaluate() of every profile from either; then the cost of an evaluation per profile
+    bool checkIncremental(int games) {
+        int wrongTerms = 0;
+        int wrongScores = 0;
+        int seen = randomWalk(games * 50, 11, false, [&](const SearchPosition& position) {
+            IncrementalEval fresh(position.board());
+            wrongTerms += !sameTerms(*position.evaluation(), fresh, position.dimension());
+            for (auto difficulty : { Difficulty::Easy, Difficulty::Medium, Difficulty::Hard }) {
+                wrongScores += withProfile(difficulty, [&](auto profile) {
+                    return evaluate(position.state(), *position.evaluation(), Player::White, profile)
+                        != evaluate(position.state(), fresh, Player::White, profile);
+                });
+            }
+        });
+        std::printf("incremental: %d positions, %d with wrong terms, %d wrong scores\n", seen, wrongTerms, wrongScores);
+
+        auto positions = randomPositions(games, 13);
+        std::vector<SearchPosition> searched;
+        for (const auto& state : positions) {
+            searched.emplace_back(state);
+        }
+        const std::pair<Difficulty, const char*> levels[] = { { Difficulty::Easy, "Easy" }, { Difficulty::Medium, "Medium" },
+            { Difficulty::Hard, "Hard" } };
+        for (const auto& level : levels) {
+            Difficulty difficulty = level.first;
+            int sink = 0;
+            std::size_t next = 0;
+            double perCall = microseconds(positions, [&](const GameState&) {
+                const SearchPosition& position = searched[next++ % searched.size()];
+                sink += evaluate(position.state(), *position.evaluation(), Player::White, difficulty);
+            });
+            std::printf("incremental: %s evaluation in %.2f us (%d)\n", level.second, perCall, sink & 1);
+        }
+        return wrongTerms == 0 && wrongScores == 0;
+    }
+
+    // The fixed-point centrality tables against the exact 1 - distance / (2 * maximum distance), and
+    // detail::spatialInfluenceScore against the same term worked out per queen in whole numbers
+    bool checkCentrality(int games) {
+        int inexact = 0;
+        for (const auto& config : kBoardSizeConfigs) {
+            int dim = config.dimension;
+            int quarterSpan = 4 * (dim - 1);  // four times the maximum distance from the centre
+            for (int square = 0; square < dim * dim; ++square) {
+                int twiceDist = std::abs(2 * (square / dim) - (dim - 1)) + std::abs(2 * (square % dim) - (dim - 1));
+                inexact += IncrementalEval::centrality(dim, square) * quarterSpan
+                    != IncrementalEval::kCentralityOne * (quarterSpan - twiceDist);
+            }
+        }
+
+        // Per queen: a quarter point per square it reaches plus 10 points of centrality, here all
+        // times 4 * (dim - 1) so every part is whole
+        auto positions = randomPositions(games, 37);
+        int wrongScores = 0;
+        for (const auto& state : positions) {
+            int dim = state.board().dimension();
+            int quarterSpan = 4 * (dim - 1);
+            auto scaledValue = [&](Player player) {
+                int total = 0;
+                for (const auto& queen : state.queenPositions(player)) {
+                    int reach = 0;
+                    forEachReachableSquare(state.board().tiles(), dim, queen.row * dim + queen.col, -1, [&](int) { ++reach; });
+                    int twiceDist = std::abs(2 * queen.row - (dim - 1)) + std::abs(2 * queen.col - (dim - 1));
+                    total += reach * (dim - 1) + 10 * (quarterSpan - twiceDist);
+                }
+                return total;
+            };
+            int expected = (scaledValue(Player::White) - scaledValue(Player::Black)) / quarterSpan;
+            wrongScores += detail::spatialInfluenceScore(IncrementalEval(state.board()), Player::White) != expected;
+        }
+        std::printf("centrality: %d inexact table entries, %zu positions, %d wrong spatial scores\n", inexact,
+            positions.size(), wrongScores);
+        return inexact == 0 && wrongScores == 0;
+    }
+
+    // 'state' under symmetry 'sym'
+    GameState imageOf(const GameState& state, int sym) {
+        GameState image = state;
+        int dim = state.board().dimension();
+        for (int square = 0; square < dim * dim; ++square) {
+            int target = symmetry::apply(sym, dim, square);
+            image.board().setTile(target / dim, target % dim, state.board().tiles()[static_cast<std::size_t>(square)]);
+        }
+        for (Player player : { Player::White, Player::Black }) {
+            for (auto& queen : image.queenPositions(player)) {
+                int target = symmetry::apply(sym, dim, queen.row * dim + queen.col);
+                queen = { target / dim, target % dim };
+            }
+        }
+        return image;
+    }
+
+    // Tiles of 'state' mapped by 'sym', the orientation TT move hints are stored in
+    std::vector<TileContent> canonicalTiles(const GameState& state, int sym) {
+        int dim = state.board().dimension();
+        std::vector<TileContent> tiles(static_cast<std::size_t>(dim * dim));
+        for (int square = 0; square < dim * dim; ++square) {
+            tiles[static_cast<std::size_t>(symmetry::apply(sym, dim, square))] = state.board().tiles()[static_cast<std::size_t>(square)];
+        }
+        return tiles;
+    }
+
+    // All 8 images of a position must get the same canonical hash, and their symmetries must map
+    // them onto the same board; the canonical hash SearchPosition keeps up to date on make/unmake
+    // (including the pending arrow between half-moves) against one worked out from the board
+    bool checkSymmetry(int games) {
+        int wrongImages = 0;
+        auto positions = randomPositions(games, 37);
+        for (const auto& state : positions) {
+            int sym = 0;
+            std::uint64_t hash = zobrist::canonicalHashOf(state, sym);
+            auto tiles = canonicalTiles(state, sym);
+            for (int image = 1; image < symmetry::kCount; ++image) {
+                GameState mapped = imageOf(state, image);
+                int imageSym = 0;
+                wrongImages += zobrist::canonicalHashOf(mapped, imageSym) != hash || canonicalTiles(mapped, imageSym) != tiles;
+            }
+        }
+
+        int wrongHashes = 0;
+        int seen = randomWalk(games * 50, 41, false, [&](const SearchPosition& position) {
+            auto hashes = zobrist::symmetricHashesOf(position.state());
+            if (position.pendingShooter().isValid()) {
+                int shooter = position.squareIndex(position.pendingShooter());
+                for (int sym = 0; sym < symmetry::kCount; ++sym) {
+                    hashes[static_cast<std::size_t>(sym)] ^= zobrist::kKeys.pendingArrow[static_cast<std::size_t>(
+                        symmetry::apply(sym, position.dimension(), shooter))];
+                }
+            }
+            int keptSym = 0;
+            int freshSym = 0;
+            wrongHashes += position.canonicalHash(keptSym) != zobrist::canonicalHash(hashes, freshSym) || keptSym != freshSym;
+        });
+        std::printf("symmetry: %zu positions with %d wrong images, %d walk positions with %d wrong hashes\n", positions.size(),
+            wrongImages, seen, wrongHashes);
+        return wrongImages == 0 && wrongHashes == 0;
+    }
+
+    // Fixed-depth Medium and Hard alpha-beta play through one SearchSession per board size, with
+    // the evaluation cache (kept for the whole game, as in the interface) and without: the moves
+    // must agree; prints the hit rate and both times
+    bool checkCache(int games) {
+        int turns = std::max(2, games / 40);
+        bool passed = true;
+        for (auto difficulty : { Difficulty::Medium, Difficulty::Hard }) {
+            SearchLimits limits = searchLimitsForDifficulty(difficulty);
+            limits.timeBudget = std::chrono::hours(1);
+            limits.threads = 1;
+            limits.useBook = false;
+            limits.perfectPlay = false;
+            limits.proofSquares = 0;
+            int different = 0;
+            EvalCache::Stats stats;
+            std::array<double, 2> seconds{};
+            for (const auto& config : kBoardSizeConfigs) {
+                std::array<std::vector<Move>, 2> played;
+                for (std::size_t cached = 0; cached < 2; ++cached) {
+                    SearchLimits run = limits;
+                    run.evalCacheMegabytes = cached ? limits.evalCacheMegabytes : 0;
+                    SearchSession session;
+                    GameState state;
+                    state.startNewGame(config.id, difficulty);
+                    std::mt19937 rng(17);
+                    for (int turn = 0; turn < 4 + turns && !state.isFinished(); ++turn) {
+                        Move move;
+                        if (turn < 4) {
+                            auto moves = generateMovesForPlayer(state, state.currentPlayer());
+                            move = moves[rng() % moves.size()];
+                        }
+                        else {
+                            auto start = std::chrono::steady_clock::now();
+                            move = session.bestMove(state, run, difficulty);
+                            seconds[cached] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                            played[cached].push_back(move);
+                        }
+                        if (move.player == Player::None) {
+                            break;
+                        }
+                        applyMove(state, move);
+                    }
+                    if (cached) {
+                        stats.probes += session.evalCacheStats().probes;
+                        stats.hits += session.evalCacheStats().hits;
+                    }
+                }
+                different += played[0] != played[1];
+            }
+            std::printf("cache: %s depth %d, %d moves per board size, %d games that differ, %.1f%% hits, %.2fs cached, "
+                "%.2fs uncached\n", difficulty == Difficulty::Hard ? "Hard" : "Medium", limits.maxDepth, turns, different,
+                100.0 * stats.hitRate(), seconds[1], seconds[0]);
+            passed = passed && different == 0;
+        }
+        return passed;
+    }
+
+    // An idle split-point scheduler must not burn CPU; then split-point games on 6x6 and 8x8, with
+    // and without half-move search and with one search cancelled, must only play legal moves
+    bool checkSplitPoints(int games) {
+        std::clock_t idleStart = std::clock();
+        {
+            WorkStealingScheduler scheduler(4);
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        }
+        double idleMs = 1000.0 * static_cast<double>(std::clock() - idleStart) / CLOCKS_PER_SEC;
+
+        int illegal = 0;
+        int cancelled = 0;
+        int turns = std::min(40, std::max(4, games / 10));
+        for (auto dimension : { BoardDimension::Six, BoardDimension::Eight }) {
+            for (bool halfMoves : { false, true }) {
+                SearchLimits limits = searchLimitsForDifficulty(Difficulty::Hard);
+                limits.threads = 4;
+                limits.parallelism = SearchParallelism::SplitPoints;
+                limits.timeBudget = std::chrono::milliseconds(100);
+                limits.halfMoveSearch = halfMoves;
+                limits.useBook = false;
+                limits.perfectPlay = false;
+                GameState state;
+                state.startNewGame(dimension, Difficulty::Hard);
+                for (int turn = 0; turn < turns && !state.isFinished(); ++turn) {
+                    std::atomic_bool cancel{ false };
+                    std::thread canceller;
+                    if (turn == turns / 2) {
+                        canceller = std::thread([&cancel]() {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+                            cancel.store(true);
+                        });
+                    }
+                    Move move;
+                    bool searched = true;
+                    try {
+                        move = getBestMove(state, limits, Difficulty::Hard, &cancel);
+                    }
+                    catch (const SearchCanceled&) {
+                        ++cancelled;
+                        searched = false;
+                    }
+                    if (canceller.joinable()) {
+                        canceller.join();
+                    }
+                    if (!searched || move.player == Player::None) {
+                        continue;
+                    }
+                    if (!isMoveLegal(state, move)) {
+                        ++illegal;
+                        break;
+                    }
+                    applyMove(state, move);
+                }
+            }
+        }
+        std::printf("splitpoints: %.0f ms CPU for 300 ms of four idle workers, %d illegal moves, %d searches cancelled\n",
+            idleMs, illegal, cancelled);
+        return idleMs < 30.0 && illegal == 0;
+    }
+
+    // Hard alpha-beta on one thread, to depths 4 and 5 on 10x10 positions 0, 6 and 20 random turns
+    // in; only the times
+    bool checkDepth(int) {
+        std::mt19937 rng(43);
+        for (int turns : { 0, 6, 20 }) {
+            GameState state;
+            state.startNewGame(BoardDimension::Ten, Difficulty::Hard);
+            for (int turn = 0; turn < turns; ++turn) {
+                auto moves = generateMovesForPlayer(state, state.currentPlayer());
+                applyMove(state, moves[rng() % moves.size()]);
+            }
+            for (int depth : { 4, 5 }) {
+                SearchLimits limits = searchLimitsForDifficulty(Difficulty::Hard);
+                limits.threads = 1;
+                limits.maxDepth = depth;
+                limits.timeBudget = std::chrono::hours(1);
+                limits.useBook = false;
+                limits.perfectPlay = false;
+                limits.proofSquares = 0;
+                auto start = std::chrono::steady_clock::now();
+                getBestMove(state, limits, Difficulty::Hard);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                std::printf("depth: 10x10 after %d turns, Hard to depth %d in %.2fs\n", turns, depth, elapsed.count());
+                std::fflush(stdout);
+            }
+        }
+        return true;
+    }
+
+    // Random 10x10 games played until no region holds queens of both colours: where the region
+    // solver's totals are exact, its move must be legal and cost the side to move exactly one move
+    // of its total and none of the opponent's; then the time Hard's getBestMove takes in those
+    bool checkSettled(int games) {
+        std::mt19937 rng(47);
+        SearchLimits limits = searchLimitsForDifficulty(Difficulty::Hard);
+        limits.useBook = false;
+        limits.perfectPlay = false;
+        int settled = 0;
+        int exact = 0;
+        int wrong = 0;
+        double slowest = 0.0;
+        std::chrono::duration<double, std::milli> total{};
+        for (int game = 0; game < games; ++game) {
+            GameState state;
+            state.startNewGame(BoardDimension::Ten, Difficulty::Hard);
+            regions::RegionAnalysis analysis;
+            while (!(analysis = regions::RegionSolver().analyse(state)).settled) {
+                auto moves = generateMovesForPlayer(state, state.currentPlayer());
+                if (moves.empty()) {
+                    break;  // over while two queens still touch
+                }
+                applyMove(state, moves[rng() % moves.size()]);
+            }
+            if (!analysis.settled) {
+                continue;
+            }
+            ++settled;
+            if (analysis.own.lower != analysis.own.upper || analysis.opponent.lower != analysis.opponent.upper) {
+                continue;
+            }
+            ++exact;
+            if (analysis.move.player != Player::None) {
+                bool legal = analysis.move.player == state.currentPlayer() && isMoveLegal(state, analysis.move);
+                if (legal) {
+                    GameState after = state;
+                    applyMove(after, analysis.move);
+                    auto next = regions::RegionSolver().analyse(after);
+                    legal = next.opponent.lower == analysis.own.lower - 1 && next.opponent.upper == analysis.own.upper - 1
+                        && next.own.lower == analysis.opponent.lower && next.own.upper == analysis.opponent.upper;
+                }
+                wrong += !legal;
+            }
+            auto start = std::chrono::steady_clock::now();
+            getBestMove(state, limits, Difficulty::Hard);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            total += elapsed;
+            slowest = std::max(slowest, elapsed.count());
+        }
+        std::printf("settled: %d positions, %d exact, %d wrong moves; Hard moves in %.2f ms on average, %.1f ms at most\n",
+            settled, exact, wrong, total.count() / std::max(1, exact), slowest);
+        return wrong == 0;
+    }
+
+    // Random 10x10 games, one in 50 of 'games': in every position where Hard would start the
+    // prover, df-pn with Hard's node budget and half its time budget; counted apart where private
+    // regions hold more than the threshold of empty squares as well. Only counts and times.
+    bool checkProver(int games) {
+        SearchLimits limits = searchLimitsForDifficulty(Difficulty::Hard);
+        std::mt19937 rng(53);
+        std::array<int, 2> started{};
+        std::array<int, 2> proven{};
+        std::array<double, 2> seconds{};
+        for (int game = 0; game < std::max(1, games / 50); ++game) {
+            GameState state;
+            state.startNewGame(BoardDimension::Ten, Difficulty::Hard);
+            while (true) {
+                auto moves = generateMovesForPlayer(state, state.currentPlayer());
+                int contested = proof::contestedSquareCount(state);
+                if (moves.empty() || contested == 0) {
+                    break;
+                }
+                if (contested <= limits.proofSquares) {
+                    int open = 0;
+                    for (const auto& region : regions::findRegions(state.board())) {
+                        open += region.emptySquares;
+                    }
+                    std::size_t large = open > limits.proofSquares ? 1 : 0;
+                    auto start = std::chrono::steady_clock::now();
+                    auto outcome = proveEndgame(state, limits.proofNodes, start + limits.timeBudget / 2, nullptr,
+                        limits.proofTableMegabytes);
+                    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                    ++started[large];
+                    proven[large] += outcome.result != ProofResult::Unknown;
+                    seconds[large] += elapsed.count();
+                }
+                applyMove(state, moves[rng() % moves.size()]);
+            }
+        }
+        const char* kinds[] = { "with few open squares", "with large private regions" };
+        for (std::size_t large = 0; large < 2; ++large) {
+            std::printf("prover: %d positions %s, %d proven, %.2fs on average\n", started[large], kinds[large], proven[large],
+                seconds[large] / std::max(1, started[large]));
+        }
+        return true;
+    }
+
+    // Same labelling up to region ids, sizes, queen counts and contested count
+    bool sameRegions(const regions::RegionMap& kept, const regions::RegionMap& fresh, int dim) {
+        std::array<int, regions::RegionMap::kMaxSquares> keptOf;
+        std::array<int, regions::RegionMap::kMaxSquares> freshOf;
+        keptOf.fill(-1);
+        freshOf.fill(-1);
+        for (int square = 0; square < dim * dim; ++square) {
+            std::uint8_t keptId = kept.regionOf(square);
+            std::uint8_t freshId = fresh.regionOf(square);
+            if ((keptId == regions::RegionMap::kNone) != (freshId == regions::RegionMap::kNone)) {
+                return false;
+            }
+            if (keptId == regions::RegionMap::kNone) {
+                continue;
+            }
+            if (keptOf[freshId] < 0 && freshOf[keptId] < 0) {
+                keptOf[freshId] = keptId;
+                freshOf[keptId] = freshId;
+            }
+            if (keptOf[freshId] != keptId || freshOf[keptId] != freshId || kept.size(keptId) != fresh.size(freshId)
+                || kept.queens(keptId, Player::White) != fresh.queens(freshId, Player::White)
+                || kept.queens(keptId, Player::Black) != fresh.queens(freshId, Player::Black)) {
+                return false;
+            }
+        }
+        return kept.contestedRegions() == fresh.contestedRegions();
+    }
+
+    // The region map SearchPosition keeps up to date on make/unmake against one built from the
+    // board, and regions::findRegions read off it against the flood-filling one
+    bool checkRegions(int games) {
+        int wrongMaps = 0;
+        int wrongRegions = 0;
+        int seen = randomWalk(games * 50, 31, true, [&](const SearchPosition& position) {
+            wrongMaps += !sameRegions(*position.regions(), regions::RegionMap(position.board()), position.dimension());
+            auto flooded = regions::findRegions(position.board());
+            auto mapped = regions::findRegions(position.board(), *position.regions());
+            bool same = flooded.size() == mapped.size();
+            for (std::size_t idx = 0; same && idx < flooded.size(); ++idx) {
+                same = flooded[idx].key == mapped[idx].key && flooded[idx].squares == mapped[idx].squares
+                    && flooded[idx].queens == mapped[idx].queens && flooded[idx].owner == mapped[idx].owner
+                    && flooded[idx].contested == mapped[idx].contested && flooded[idx].emptySquares == mapped[idx].emptySquares;
+            }
+            wrongRegions += !same;
+        });
+        std::printf("regions: %d positions, %d wrong maps, %d wrong region lists\n", seen, wrongMaps, wrongRegions);
+        return wrongMaps == 0 && wrongRegions == 0;
+    }
+
+    // batch::evaluateTerms and the batched evaluate() of one profile against the scalar terms and
+    // evaluate(), from both sides; then both timed, the batch including filling it
+    template <typename Profile>
+    bool checkBatchProfile(const char* name, const std::vector<GameState>& positions, Profile profile) {
+        batch::PositionBatch filled;
+        for (const auto& state : positions) {
+            filled.add(state);
+        }
+        int wrongTerms = 0;
+        int wrongScores = 0;
+        for (Player perspective : { Player::White, Player::Black }) {
+            std::vector<batch::Terms> terms;
+            batch::evaluateTerms(filled, perspective, profile, terms);
+            std::vector<int> scores;
+            evaluate(filled, perspective, profile, scores);
+            for (std::size_t idx = 0; idx < positions.size(); ++idx) {
+                const GameState& state = positions[idx];
+                if (state.isFinished()) {
+                    wrongScores += scores[idx] != evaluate(state, perspective, profile);
+                    continue;
+                }
+                Player opponent = perspective == Player::White ? Player::Black : Player::White;
+                bool same = terms[idx].mobility == detail::mobilityCount(state, perspective) - detail::mobilityCount(state, opponent);
+                if constexpr (Profile::kSpatial) {
+                    same = same && terms[idx].spatial == detail::spatialInfluenceScore(IncrementalEval(state.board()), perspective);
+                }
+                if constexpr (Profile::kTerritory) {
+                    same = same && terms[idx].territory == detail::territoryScore(state, perspective);
+                }
+                wrongTerms += !same;
+                wrongScores += scores[idx] != evaluate(state, perspective, profile);
+            }
+        }
+
+        int sink = 0;
+        double scalar = microseconds(positions, [&](const GameState& state) { sink += evaluate(state, Player::White, profile); });
+        std::vector<int> scores;
+        auto start = std::chrono::steady_clock::now();
+        constexpr int kRepeats = 20;
+        for (int repeat = 0; repeat < kRepeats; ++repeat) {
+            batch::PositionBatch timed;
+            for (const auto& state : positions) {
+                timed.add(state);
+            }
+            evaluate(timed, Player::White, profile, scores);
+            sink += scores[0];
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        double batched = elapsed.count() / (kRepeats * static_cast<double>(positions.size()));
+        std::printf("batch: %s, %d wrong terms, %d wrong scores; %.2f us scalar, %.2f us batched with %zu lanes (%d)\n", name,
+            wrongTerms, wrongScores, scalar, batched, batch::kLanes, sink & 1);
+        return wrongTerms == 0 && wrongScores == 0;
+    }
+
+    bool checkBatch(int games) {
+        auto positions = randomPositions(games, 41);
+        bool easy = checkBatchProfile("Easy", positions, EasyProfile{});
+        bool medium = checkBatchProfile("Medium", positions, MediumProfile{});
+        bool hard = checkBatchProfile("Hard", positions, HardProfile{});
+        return easy && medium && hard;
+    }
+
+    // A random network written to and loaded from 'path': the accumulator SearchPosition keeps up to
+    // date on make/unmake against a refresh, and Network::evaluate (AVX2 when compiled with it)
+    // against the output layer in plain integers. The network stays loaded, so this check runs last.
+    bool checkNetwork(int games) {
+        constexpr std::int32_t kOutputBias = 123;
+        constexpr std::int32_t kOutputDivisor = 16;
+        const char* path = "EngineCheck.nnue";
+        std::mt19937 rng(19);
+        std::vector<std::int16_t> featureWeights(std::size_t{ nnue::kFeatures } * nnue::kHidden);
+        std::array<std::int16_t, nnue::kHidden> featureBias;
+        std::array<std::int8_t, 2 * nnue::kHidden> outputWeights;
+        for (auto& weight : featureWeights) weight = static_cast<std::int16_t>(static_cast<int>(rng() % 41) - 20);
+        for (auto& weight : featureBias) weight = static_cast<std::int16_t>(static_cast<int>(rng() % 81) - 20);
+        for (auto& weight : outputWeights) weight = static_cast<std::int8_t>(static_cast<int>(rng() % 256) - 128);
+        auto& network = nnue::Network::instance();
+        bool loaded = nnue::Network::write(path, featureWeights, featureBias, outputWeights, kOutputBias, kOutputDivisor)
+            && network.load(path);
+        std::remove(path);
+        if (!loaded) {
+            std::printf("network: could not write and load %s\n", path);
+            return false;
+        }
+
+        auto plainEvaluate = [&](const nnue::Accumulator& accumulator, Player toMove) {
+            std::int32_t sum = 0;
+            for (std::size_t half = 0; half < 2; ++half) {
+                const auto& values = accumulator.values[half == 0 ? nnue::side(toMove) : 1 - nnue::side(toMove)];
+                for (std::size_t idx = 0; idx < values.size(); ++idx) {
+                    sum += std::clamp<int>(values[idx], 0, nnue::kClip) * outputWeights[half * nnue::kHidden + idx];
+                }
+            }
+            return (sum + kOutputBias) / kOutputDivisor;
+        };
+        int wrongAccumulators = 0;
+        int wrongScores = 0;
+        int seen = randomWalk(games * 50, 23, false, [&](const SearchPosition& position) {
+            nnue::Accumulator fresh;
+            network.refresh(fresh, position.board());
+            wrongAccumulators += fresh.values != position.accumulator()->values;
+            for (Player player : { Player::White, Player::Black }) {
+                wrongScores += network.evaluate(*position.accumulator(), player) != plainEvaluate(fresh, player);
+            }
+        });
+        std::printf("network: %d positions, %d wrong accumulators, %d wrong scores\n", seen, wrongAccumulators, wrongScores);
+
+        auto positions = randomPositions(games, 29);
+        std::vector<nnue::Accumulator> accumulators(positions.size());
+        for (std::size_t idx = 0; idx < positions.size(); ++idx) {
+            network.refresh(accumulators[idx], positions[idx].board());
+        }
+        int sink = 0;
+        std::size_t next = 0;
+        double perCall = microseconds(positions, [&](const GameState&) {
+            sink += network.evaluate(accumulators[next++ % accumulators.size()], Player::White);
+        });
+#if defined(__AVX2__)
+        const char* kernel = "AVX2";
+#else
+        const char* kernel = "scalar";
+#endif
+        std::printf("network: %s evaluation in %.0f ns (%d)\n", kernel, perCall * 1000.0, sink & 1);
+        return wrongAccumulators == 0 && wrongScores == 0;
+    }
+
+    struct Check {
+        const char* name;
+        bool (*run)(int games);
+    };
+
+    constexpr Check kChecks[] = {
+        { "distance", checkDistance },
+        { "territory", checkTerritory },
+        { "incremental", checkIncremental },
+        { "centrality", checkCentrality },
+        { "symmetry", checkSymmetry },
+        { "cache", checkCache },
+        { "splitpoints", checkSplitPoints },
+        { "depth", checkDepth },
+        { "settled", checkSettled },
+        { "prover", checkProver },
+        { "regions", checkRegions },
+        { "batch", checkBatch },
+        { "network", checkNetwork },
+    };
+}
+
+int main(int argc, const char** argv) {
+    const char* only = argc > 1 ? argv[1] : nullptr;
+    int games = argc > 2 ? std::atoi(argv[2]) : 300;
+    bool known = only == nullptr;
+    bool passed = true;
+    for (const auto& check : kChecks) {
+        if (only == nullptr || std::strcmp(only, check.name) == 0) {
+            known = true;
+            passed = check.run(games) && passed;
+        }
+    }
+    if (!known || games < 1) {
+        std::fprintf(stderr, "Usage: EngineCheck [check] [games per board size]\nChecks:");
+        for (const auto& check : kChecks) {
+            std::fprintf(stderr, " %s", check.name);
+        }
+        std::fprintf(stderr, "\n");
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// Headless matches between two engine configurations, for checking that a change to the search or
+// the evaluation actually plays better. Each pair of games starts from the same few random turns
+// with colours swapped, so neither side profits from a lucky opening.
+// Usage: EngineMatch [engine A] [engine B] [board size] [games] [ms per move] [threads]
+// Engines: easy, medium or hard (the settings of that difficulty), with "-mcts" or "-alphabeta"
+// appended to force the engine, e.g. "hard-mcts". Books, the 6x6 database and pondering are off.
+#include "Algorithms.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace {
+    constexpr int kRandomPlies = 2;  // random opening turns shared by the two games of a pair
+
+    struct Engine {
+        std::string name;
+        Difficulty difficulty = Difficulty::Hard;
+        SearchLimits limits;
+    };
+
+    bool parseEngine(const char* text, std::chrono::milliseconds budget, unsigned threads, Engine& engine) {
+        std::string spec = text;
+        std::string level = spec.substr(0, spec.find('-'));
+        std::string variant = spec.find('-') == std::string::npos ? "" : spec.substr(spec.find('-') + 1);
+        if (level == "easy") engine.difficulty = Difficulty::Easy;
+        else if (level == "medium") engine.difficulty = Difficulty::Medium;
+        else if (level == "hard") engine.difficulty = Difficulty::Hard;
+        else return false;
+
+        engine.name = spec;
+        engine.limits = searchLimitsForDifficulty(engine.difficulty);
+        if (variant == "mcts") engine.limits.engine = SearchEngine::MonteCarlo;
+        else if (variant == "alphabeta") engine.limits.engine = SearchEngine::AlphaBeta;
+        else if (!variant.empty()) return false;
+        engine.limits.timeBudget = budget;
+        engine.limits.threads = threads;
+        engine.limits.useBook = false;
+        engine.limits.perfectPlay = false;
+        engine.limits.ponder = false;
+        return true;
+    }
+
+    // Plays one game; true if 'white' won it
+    bool play(const Engine& white, const Engine& black, BoardDimension dimension, std::uint32_t seed) {
+        GameState state;
+        state.startNewGame(dimension, white.difficulty);
+        std::mt19937 rng(seed);
+        for (int ply = 0; !state.isFinished(); ++ply) {
+            const Engine& engine = state.currentPlayer() == Player::White ? white : black;
+            Move move;
+            if (ply < kRandomPlies) {
+                auto moves = generateMovesForPlayer(state, state.currentPlayer());
+                if (!moves.empty()) {
+                    move = moves[std::uniform_int_distribution<std::size_t>(0, moves.size() - 1)(rng)];
+                }
+            }
+            else {
+                move = getBestMove(state, engine.limits, engine.difficulty);
+            }
+            if (move.player == Player::None) {
+                evaluateWinState(state);
+                break;
+            }
+            applyMove(state, move);
+        }
+        return state.winner() == Player::White;
+    }
+}
+
+int main(int argc, const char** argv) {
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    int size = argc > 3 ? std::atoi(argv[3]) : 8;
+    int games = argc > 4 ? std::atoi(argv[4]) : 10;
+    auto budget = std::chrono::milliseconds(argc > 5 ? std::atoi(argv[5]) : 300);
+    unsigned threads = std::max(1u, argc > 6 ? static_cast<unsigned>(std::atoi(argv[6])) : hardware);
+    auto config = std::find_if(kBoardSizeConfigs.begin(), kBoardSizeConfigs.end(),
+        [&](const BoardSizeConfig& candidate) { return candidate.dimension == size; });
+
+    Engine a, b;
+    if (argc < 3 || !parseEngine(argv[1], budget, threads, a) || !parseEngine(argv[2], budget, threads, b)
+        || config == kBoardSizeConfigs.end() || games < 1) {
+        std::fprintf(stderr, "Usage: EngineMatch [engine A] [engine B] [board size] [games] [ms per move] [threads]\n"
+                             "Engines: easy, medium or hard, optionally with -mcts or -alphabeta\n");
+        return 1;
+    }
+
+    int winsA = 0;
+    for (int game = 0; game < games; ++game) {
+        bool aIsWhite = game % 2 == 0;
+        auto seed = static_cast<std::uint32_t>(1000 + game / 2);
+        bool whiteWon = aIsWhite ? play(a, b, config->id, seed) : play(b, a, config->id, seed);
+        bool aWon = whiteWon == aIsWhite;
+        winsA += aWon;
+        std::printf("game %d: %s (%s) wins\n", game + 1, aWon ? a.name.c_str() : b.name.c_str(), aWon == aIsWhite ? "white" : "black");
+        std::fflush(stdout);
+    }
+    std::printf("%s %d - %d %s on %dx%d at %lld ms per move\n", a.name.c_str(), winsA, games - winsA, b.name.c_str(),
+        size, size, static_cast<long long>(budget.count()));
+    return 0;
+}
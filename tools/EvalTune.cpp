@@ -0,0 +1,350 @@
+// Offline tuner for the weights of the hand-written evaluation (Texel method). 'label' plays
+// headless Hard self-play games and writes every position with the game's result. 'tune' fits,
+// for each profile that adds up more than one term, the weights of its terms (Medium: mobility
+// and spatial influence, Hard: those and territory) so that a sigmoid of that profile's
+// evaluation predicts those results, by gradient descent over all positions split across threads.
+// Weights stay positive. It writes a weights file the engine loads at startup
+// (res/data/eval.weights); Easy, a single term, keeps its weights.
+// Usage: EvalTune label [positions path] [games per board size] [ms per move] [threads]
+//        EvalTune tune [positions path] [weights path] [iterations] [threads]
+// Positions file: one per line, the board row by row ('.' empty, 'W'/'B' queens, 'x' arrow), the
+// side to move ('w'/'b') and the result for White (1 won, 0 lost, anything between for a share).
+#include "Algorithms.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int kRandomPlies = 4;  // random opening turns, so the games differ
+    constexpr int kTerms = 3;        // mobility, spatial influence, territory
+    constexpr double kMinWeight = 1.0;  // in sixteenths; a term never counts against its own side
+
+    // A profile to fit and the terms its evaluation adds up
+    struct Fit {
+        const char* name;
+        std::size_t profile;
+        std::array<bool, kTerms> terms;
+    };
+
+    constexpr std::array<Fit, 2> kFits = { {
+        { "Medium", MediumProfile::kId, { true, true, false } },
+        { "Hard", HardProfile::kId, { true, true, true } },
+    } };
+
+    // Evaluation terms of one position from White's view, and the result
+    struct Sample {
+        std::array<double, kTerms> terms;
+        double result;
+    };
+
+    std::string encode(const GameState& state) {
+        std::string text;
+        for (TileContent tile : state.board().tiles()) {
+            switch (tile) {
+            case TileContent::WhiteQueen: text += 'W'; break;
+            case TileContent::BlackQueen: text += 'B'; break;
+            case TileContent::Arrow: text += 'x'; break;
+            default: text += '.'; break;
+            }
+        }
+        text += state.currentPlayer() == Player::White ? " w" : " b";
+        return text;
+    }
+
+    bool decode(const std::string& line, GameState& state, double& result) {
+        std::istringstream in(line);
+        std::string tiles, side;
+        if (!(in >> tiles >> side >> result)) {
+            return false;
+        }
+        auto config = std::find_if(kBoardSizeConfigs.begin(), kBoardSizeConfigs.end(), [&](const BoardSizeConfig& size) {
+            return static_cast<std::size_t>(size.dimension * size.dimension) == tiles.size();
+        });
+        if (config == kBoardSizeConfigs.end()) {
+            return false;
+        }
+        state.startNewGame(config->id, Difficulty::Hard);
+        state.board().clear();
+        state.queenPositions(Player::White).clear();
+        state.queenPositions(Player::Black).clear();
+        for (std::size_t idx = 0; idx < tiles.size(); ++idx) {
+            Position pos{ static_cast<int>(idx) / config->dimension, static_cast<int>(idx) % config->dimension };
+            switch (tiles[idx]) {
+            case 'W':
+                state.board().setTile(pos.row, pos.col, TileContent::WhiteQueen);
+                state.queenPositions(Player::White).push_back(pos);
+                break;
+            case 'B':
+                state.board().setTile(pos.row, pos.col, TileContent::BlackQueen);
+                state.queenPositions(Player::Black).push_back(pos);
+                break;
+            case 'x': state.addArrow(pos); break;
+            case '.': break;
+            default: return false;
+            }
+        }
+        state.setCurrentPlayer(side == "b" ? Player::Black : Player::White);
+        return true;
+    }
+
+    int label(const char* path, int gamesPerSize, std::chrono::milliseconds budget, unsigned threads) {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) {
+            std::fprintf(stderr, "Could not write %s\n", path);
+            return 1;
+        }
+        std::mutex outMutex;
+        std::atomic<int> nextGame{ 0 };
+        std::atomic<std::size_t> positions{ 0 };
+        int totalGames = gamesPerSize * static_cast<int>(kBoardSizeConfigs.size());
+
+        auto worker = [&](unsigned id) {
+            std::mt19937 rng(0x7E7Eu + id);
+            SearchLimits limits = searchLimitsForDifficulty(Difficulty::Hard);
+            limits.threads = 1;
+            limits.timeBudget = budget;
+            limits.useBook = false;
+            limits.neuralEval = false;
+
+            for (int game = nextGame++; game < totalGames; game = nextGame++) {
+                GameState state;
+                state.startNewGame(kBoardSizeConfigs[static_cast<std::size_t>(game) % kBoardSizeConfigs.size()].id, Difficulty::Hard);
+                std::vector<std::string> seen;
+                for (int ply = 0; !state.isFinished(); ++ply) {
+                    Move move;
+                    if (ply < kRandomPlies) {
+                        auto moves = generateMovesForPlayer(state, state.currentPlayer());
+                        if (!moves.empty()) {
+                            move = moves[std::uniform_int_distribution<std::size_t>(0, moves.size() - 1)(rng)];
+                        }
+                    }
+                    else {
+                        seen.push_back(encode(state));
+                        move = getBestMove(state, limits, Difficulty::Hard);
+                    }
+                    if (move.player == Player::None) {
+                        break;
+                    }
+                    applyMove(state, move);
+                }
+
+                const char* result = state.winner() == Player::White ? " 1\n" : " 0\n";
+                {
+                    std::lock_guard<std::mutex> lock(outMutex);
+                    for (const auto& position : seen) {
+                        out << position << result;
+                    }
+                }
+                positions += seen.size();
+                std::printf("game %d/%d done, %zu positions\n", game + 1, totalGames, positions.load());
+                std::fflush(stdout);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned id = 1; id < threads; ++id) {
+            pool.emplace_back(worker, id);
+        }
+        worker(0);
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        return out.flush() ? 0 : 1;
+    }
+
+    double sigmoid(double x) { return 1.0 / (1.0 + std::exp(-x)); }
+
+    // Evaluation in score units for weights in sixteenths, as evaluate() computes it before rounding;
+    // a profile's missing terms have weight 0
+    double evaluation(const Sample& sample, const std::array<double, kTerms>& weights) {
+        double sum = 0.0;
+        for (int term = 0; term < kTerms; ++term) {
+            sum += sample.terms[static_cast<std::size_t>(term)] * weights[static_cast<std::size_t>(term)];
+        }
+        return sum / EvalWeights::kScale;
+    }
+
+    // Mean squared error of the predicted results and, if 'gradient' is set, its gradient by weight
+    double meanError(const std::vector<Sample>& samples, const std::array<double, kTerms>& weights, double scale,
+        ThreadPool& pool, unsigned threads, std::array<double, kTerms>* gradient) {
+        std::vector<double> errors(threads, 0.0);
+        std::vector<std::array<double, kTerms>> gradients(threads, std::array<double, kTerms>{});
+        pool.run(threads, [&](std::size_t chunk, unsigned) {
+            for (std::size_t idx = chunk; idx < samples.size(); idx += threads) {
+                const Sample& sample = samples[idx];
+                double predicted = sigmoid(scale * evaluation(sample, weights));
+                double miss = sample.result - predicted;
+                errors[chunk] += miss * miss;
+                double slope = -2.0 * miss * predicted * (1.0 - predicted) * scale / EvalWeights::kScale;
+                for (std::size_t term = 0; term < kTerms; ++term) {
+                    gradients[chunk][term] += slope * sample.terms[term];
+                }
+            }
+        }, threads);
+
+        double error = 0.0;
+        std::array<double, kTerms> total{};
+        for (unsigned chunk = 0; chunk < threads; ++chunk) {
+            error += errors[chunk];
+            for (std::size_t term = 0; term < kTerms; ++term) {
+                total[term] += gradients[chunk][term];
+            }
+        }
+        if (gradient) {
+            for (std::size_t term = 0; term < kTerms; ++term) {
+                (*gradient)[term] = total[term] / static_cast<double>(samples.size());
+            }
+        }
+        return error / static_cast<double>(samples.size());
+    }
+
+    // Fits the weights of the terms 'fit' uses, starting from 'weights'
+    void fitProfile(const Fit& fit, const std::vector<Sample>& samples, int iterations, ThreadPool& pool, unsigned threads,
+        EvalWeights::Terms& weights) {
+        std::array<double, kTerms> fitted = { double(weights.mobility), double(weights.spatial), double(weights.territory) };
+        for (std::size_t term = 0; term < kTerms; ++term) {
+            if (!fit.terms[term]) {
+                fitted[term] = 0.0;
+            }
+        }
+
+        // Sigmoid scale that fits the current weights best (golden section on its logarithm), kept
+        // fixed while the weights move so the fit can't just rescale them
+        auto errorAt = [&](double logScale) { return meanError(samples, fitted, std::exp(logScale), pool, threads, nullptr); };
+        const double golden = (std::sqrt(5.0) - 1.0) / 2.0;
+        double low = std::log(1e-4), high = std::log(1.0);
+        for (int step = 0; step < 60; ++step) {
+            double left = high - golden * (high - low);
+            double right = low + golden * (high - low);
+            if (errorAt(left) < errorAt(right)) {
+                high = right;
+            }
+            else {
+                low = left;
+            }
+        }
+        double scale = std::exp((low + high) / 2.0);
+        double startError = meanError(samples, fitted, scale, pool, threads, nullptr);
+        std::printf("%s: scale %.6f, error %.6f with weights %.0f/%.0f/%.0f\n", fit.name, scale, startError,
+            fitted[0], fitted[1], fitted[2]);
+
+        // Adam, in sixteenths per step, projected back onto positive weights
+        constexpr double kRate = 0.5, kBeta1 = 0.9, kBeta2 = 0.999, kEpsilon = 1e-12;
+        std::array<double, kTerms> moment{}, velocity{}, gradient{};
+        double error = startError;
+        for (int iteration = 1; iteration <= iterations; ++iteration) {
+            error = meanError(samples, fitted, scale, pool, threads, &gradient);
+            for (std::size_t term = 0; term < kTerms; ++term) {
+                if (!fit.terms[term]) {
+                    continue;
+                }
+                moment[term] = kBeta1 * moment[term] + (1.0 - kBeta1) * gradient[term];
+                velocity[term] = kBeta2 * velocity[term] + (1.0 - kBeta2) * gradient[term] * gradient[term];
+                double corrected = moment[term] / (1.0 - std::pow(kBeta1, iteration));
+                double spread = velocity[term] / (1.0 - std::pow(kBeta2, iteration));
+                fitted[term] = std::max(kMinWeight, fitted[term] - kRate * corrected / (std::sqrt(spread) + kEpsilon));
+            }
+            if (iteration % 100 == 0) {
+                std::printf("%s iteration %d: error %.6f, weights %.1f/%.1f/%.1f\n", fit.name, iteration, error,
+                    fitted[0], fitted[1], fitted[2]);
+                std::fflush(stdout);
+            }
+        }
+
+        weights.mobility = static_cast<int>(std::lround(fitted[0]));
+        weights.spatial = static_cast<int>(std::lround(fitted[1]));
+        if (fit.terms[2]) {
+            weights.territory = static_cast<int>(std::lround(fitted[2]));
+        }
+        std::printf("%s: weights %d/%d/%d (sixteenths), error %.6f -> %.6f\n", fit.name, weights.mobility, weights.spatial,
+            weights.territory, startError, error);
+    }
+
+    int tune(const char* positionsPath, const char* weightsPath, int iterations, unsigned threads) {
+        std::ifstream in(positionsPath);
+        if (!in) {
+            std::fprintf(stderr, "Could not read %s\n", positionsPath);
+            return 1;
+        }
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(in, line);) {
+            if (!line.empty()) {
+                lines.push_back(line);
+            }
+        }
+
+        // Terms once up front: they don't depend on the weights, and territory dominates the time.
+        // Decoding is cheap; the terms come from the batched kernels, block by block on the pool.
+        std::vector<Sample> samples;
+        batch::PositionBatch positions;
+        positions.reserve(lines.size());
+        GameState state;
+        for (const std::string& line : lines) {
+            double result = 0.0;
+            if (decode(line, state, result)) {
+                positions.add(state);
+                samples.push_back(Sample{ {}, result });
+            }
+        }
+        ThreadPool pool(threads - 1);
+        std::vector<batch::Terms> terms;
+        batch::evaluateTerms(positions, Player::White, HardProfile{}, terms, threads, pool);
+        for (std::size_t idx = 0; idx < samples.size(); ++idx) {
+            samples[idx].terms = {
+                static_cast<double>(terms[idx].mobility),
+                static_cast<double>(terms[idx].spatial),
+                static_cast<double>(terms[idx].territory)
+            };
+        }
+        if (samples.empty()) {
+            std::fprintf(stderr, "No positions in %s\n", positionsPath);
+            return 1;
+        }
+        std::printf("%zu positions (%zu lines skipped)\n", samples.size(), lines.size() - samples.size());
+
+        EvalWeights tuned = EvalWeights::instance();
+        for (const Fit& fit : kFits) {
+            fitProfile(fit, samples, iterations, pool, threads, tuned.profiles[fit.profile]);
+        }
+        if (!tuned.write(weightsPath)) {
+            std::fprintf(stderr, "Could not write %s\n", weightsPath);
+            return 1;
+        }
+        std::printf("Wrote %s\n", weightsPath);
+        return 0;
+    }
+}
+
+int main(int argc, const char** argv) {
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1 && std::strcmp(argv[1], "label") == 0) {
+        const char* path = argc > 2 ? argv[2] : "positions.txt";
+        int gamesPerSize = argc > 3 ? std::atoi(argv[3]) : 64;
+        auto budget = std::chrono::milliseconds(argc > 4 ? std::atoi(argv[4]) : 100);
+        unsigned threads = std::max(1u, argc > 5 ? static_cast<unsigned>(std::atoi(argv[5])) : hardware);
+        return label(path, gamesPerSize, budget, threads);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "tune") == 0) {
+        const char* positionsPath = argc > 2 ? argv[2] : "positions.txt";
+        const char* weightsPath = argc > 3 ? argv[3] : "eval.weights";
+        int iterations = argc > 4 ? std::atoi(argv[4]) : 1000;
+        unsigned threads = std::max(1u, argc > 5 ? static_cast<unsigned>(std::atoi(argv[5])) : hardware);
+        return tune(positionsPath, weightsPath, iterations, threads);
+    }
+    std::fprintf(stderr, "Usage: EvalTune label [positions path] [games per board size] [ms per move] [threads]\n"
+                         "       EvalTune tune [positions path] [weights path] [iterations] [threads]\n");
+    return 1;
+}
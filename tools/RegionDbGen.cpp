@@ -0,0 +1,153 @@
+// Offline generator for the region endgame database loaded by the engine at startup. 'verify'
+// checks a database against the depth-first region solver.
+// Usage: RegionDbGen [output path] [threads]
+//        RegionDbGen verify [database path] [regions]
+#include "RegionSolver.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace {
+    int generate(const char* path, unsigned threads) {
+        auto start = std::chrono::steady_clock::now();
+        auto tables = regions::RegionDatabase::generate(threads);
+        if (!regions::RegionDatabase::write(path, tables)) {
+            std::fprintf(stderr, "Could not write %s\n", path);
+            return 1;
+        }
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (std::size_t table = 0; table < regions::kTables; ++table) {
+            const auto& layout = tables.layouts[table];
+            std::printf("%dx%d window: %zu masks, %zu values\n", layout.shape.rows, layout.shape.cols, layout.masks.size(),
+                tables.values[table].size());
+        }
+        std::printf("Wrote %s in %.1fs\n", path, seconds);
+        return 0;
+    }
+
+    // Total of the fill values 'solver' gives the regions of 'board'; 'exact' is cleared if any
+    // of them only got bounds
+    int fillTotal(regions::RegionSolver& solver, const Board& board, bool& exact) {
+        int total = 0;
+        for (const auto& region : regions::findRegions(board)) {
+            regions::FillBounds bounds = solver.solve(board, region, nullptr);
+            exact = exact && bounds.lower == bounds.upper;
+            total += bounds.lower;
+        }
+        return total;
+    }
+
+    // Table the database looks a region up in, -1 if none
+    int tableOf(const regions::Region& region) {
+        if (region.queens.size() > static_cast<std::size_t>(regions::kMaxDatabaseQueens)) {
+            return -1;
+        }
+        auto [minRow, maxRow] = std::minmax_element(region.squares.begin(), region.squares.end(),
+            [](int a, int b) { return a / 10 < b / 10; });
+        auto [minCol, maxCol] = std::minmax_element(region.squares.begin(), region.squares.end(),
+            [](int a, int b) { return a % 10 < b % 10; });
+        int rows = *maxRow / 10 - *minRow / 10 + 1;
+        int cols = *maxCol % 10 - *minCol % 10 + 1;
+        return regions::tableFor(std::min(rows, cols), std::max(rows, cols));
+    }
+
+    // Random regions in every window, in random orientations and places on a 10x10 board, each
+    // with one or two queens: the engine's solver with the database must give the values the
+    // depth-first search gives, and its first moves must be legal and cost exactly one move
+    int verify(const char* path, int count) {
+        regions::RegionDatabase database;
+        if (!database.load(path)) {
+            std::fprintf(stderr, "Could not load %s\n", path);
+            return 1;
+        }
+        std::mt19937 rng(7);
+        std::array<int, regions::kTables> lookups{};
+        int checked = 0;
+        int wrongValues = 0;
+        int wrongMoves = 0;
+        while (checked < count) {
+            const auto& shape = regions::kWindowShapes[rng() % regions::kTables];
+            bool turned = rng() % 2 == 1;
+            int rows = turned ? shape.cols : shape.rows;
+            int cols = turned ? shape.rows : shape.cols;
+            int top = static_cast<int>(rng() % static_cast<unsigned>(11 - rows));
+            int left = static_cast<int>(rng() % static_cast<unsigned>(11 - cols));
+            GameState state;
+            state.startNewGame(BoardDimension::Ten, Difficulty::Hard);
+            Board& board = state.board();
+            state.queenPositions(Player::White).clear();
+            state.queenPositions(Player::Black).clear();
+            std::vector<Position> open;
+            for (int row = 0; row < 10; ++row) {
+                for (int col = 0; col < 10; ++col) {
+                    bool inside = row >= top && row < top + rows && col >= left && col < left + cols;
+                    board.setTile(row, col, inside && rng() % 4 != 0 ? TileContent::Empty : TileContent::Arrow);
+                    if (board.getTile(row, col) == TileContent::Empty) {
+                        open.push_back({ row, col });
+                    }
+                }
+            }
+            if (open.size() < 2) {
+                continue;
+            }
+            std::shuffle(open.begin(), open.end(), rng);
+            for (std::size_t queen = 0; queen < 1 + rng() % 2; ++queen) {
+                board.setTile(open[queen].row, open[queen].col, TileContent::WhiteQueen);
+                state.queenPositions(Player::White).push_back(open[queen]);
+            }
+
+            regions::RegionSolver search(10000000, nullptr);
+            bool exact = true;
+            int value = fillTotal(search, board, exact);
+            if (!exact) {
+                continue;  // too big for the search to finish
+            }
+            ++checked;
+            regions::RegionSolver solver(50000, &database);
+            bool lookedUpExact = true;
+            wrongValues += fillTotal(solver, board, lookedUpExact) != value || !lookedUpExact;
+
+            for (const auto& region : regions::findRegions(board)) {
+                int table = tableOf(region);
+                if (table >= 0) {
+                    ++lookups[static_cast<std::size_t>(table)];
+                }
+                Move move;
+                if (solver.solve(board, region, &move).lower == 0) {
+                    continue;
+                }
+                move.player = Player::White;
+                GameState after = state;
+                bool legal = isMoveLegal(state, move);
+                if (legal) {
+                    applyMove(after, move);
+                }
+                bool afterExact = true;
+                wrongMoves += !legal || fillTotal(search, after.board(), afterExact) != value - 1;
+            }
+        }
+        for (std::size_t table = 0; table < regions::kTables; ++table) {
+            std::printf("%dx%d window: %d regions\n", regions::kWindowShapes[table].rows, regions::kWindowShapes[table].cols, lookups[table]);
+        }
+        std::printf("%d positions checked against the depth-first solver: %d wrong values, %d bad first moves\n",
+            checked, wrongValues, wrongMoves);
+        return wrongValues == 0 && wrongMoves == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, const char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "verify") == 0) {
+        const char* path = argc > 2 ? argv[2] : "regions.db";
+        int count = argc > 3 ? std::atoi(argv[3]) : 20000;
+        return verify(path, count);
+    }
+    const char* path = argc > 1 ? argv[1] : "regions.db";
+    unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : std::thread::hardware_concurrency();
+    return generate(path, threads);
+}
@@ -0,0 +1,88 @@
+// Headless solver for the 6x6 board: proves the game value from the start position and writes the
+// perfect-play database Hard loads at startup. Progress is checkpointed to the work directory; an
+// interrupted run (Ctrl+C) saves a checkpoint and picks up from it when started again.
+// Usage: Solve6x6 [work dir] [RAM table MB] [spill file MB] [minutes between checkpoints]
+#include "BoardSolver.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+    constexpr std::uint64_t kNodesPerChunk = 5000000;
+    constexpr std::uint64_t kNodesPerGap = 1000000;
+
+    std::atomic_bool stopRequested{ false };
+
+    void requestStop(int) { stopRequested = true; }
+}
+
+int main(int argc, const char** argv) {
+    std::string dir = argc > 1 ? argv[1] : ".";
+    std::size_t tableMegabytes = argc > 2 ? static_cast<std::size_t>(std::atoll(argv[2])) : 4096;
+    std::size_t spillMegabytes = argc > 3 ? static_cast<std::size_t>(std::atoll(argv[3])) : 65536;
+    auto checkpointEvery = std::chrono::minutes(argc > 4 ? std::atoi(argv[4]) : 10);
+    std::string checkpointPath = dir + "/solve6.checkpoint";
+    std::string spillPath = dir + "/solve6.spill";
+    std::string outputPath = dir + "/solved6.book";
+
+    GameState state;
+    state.startNewGame(BoardDimension::Six, Difficulty::Hard);
+    std::uint64_t rootKey = zobrist::hashOf(state);
+
+    bool resume = std::ifstream(checkpointPath).good();
+    proof::SpillFile spill;
+    if (!spill.open(spillPath, spillMegabytes, resume)) {
+        std::fprintf(stderr, "Could not open %s\n", spillPath.c_str());
+        return 1;
+    }
+    proof::DiskProofTable table(tableMegabytes, spill);
+    if (resume && !table.loadCheckpoint(checkpointPath, rootKey)) {
+        std::fprintf(stderr, "%s does not belong to this run\n", checkpointPath.c_str());
+        return 1;
+    }
+    std::printf("%s with %zu MB in RAM, %llu entries spilled\n", resume ? "Resuming" : "Starting", tableMegabytes,
+        static_cast<unsigned long long>(spill.count()));
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    auto start = std::chrono::steady_clock::now();
+    auto lastCheckpoint = start;
+    std::uint64_t nodes = 0;
+    ProofOutcome outcome;
+    while (outcome.result == ProofResult::Unknown && !stopRequested) {
+        proof::Prover<proof::DiskProofTable> prover(table, kNodesPerChunk, std::chrono::steady_clock::time_point::max(), &stopRequested);
+        outcome = prover.prove(state);
+        nodes += outcome.nodes;
+
+        auto now = std::chrono::steady_clock::now();
+        proof::Numbers root = table.lookup(rootKey);
+        std::printf("%.0fs: %llu nodes, root phi %u delta %u, %llu spilled\n", std::chrono::duration<double>(now - start).count(),
+            static_cast<unsigned long long>(nodes), root.phi, root.delta, static_cast<unsigned long long>(spill.count()));
+        std::fflush(stdout);
+        if (outcome.result != ProofResult::Unknown || stopRequested || now - lastCheckpoint >= checkpointEvery) {
+            if (!table.saveCheckpoint(checkpointPath, rootKey)) {
+                std::fprintf(stderr, "Could not write %s\n", checkpointPath.c_str());
+                return 1;
+            }
+            lastCheckpoint = now;
+        }
+    }
+    if (outcome.result == ProofResult::Unknown) {
+        std::printf("Stopped; run again to resume\n");
+        return 2;
+    }
+
+    std::printf("6x6 is a %s for the first player\n", outcome.result == ProofResult::Win ? "win" : "loss");
+    std::uint64_t gaps = 0;
+    auto entries = proof::extractPerfectPlay(state, table, kNodesPerGap, gaps);
+    if (!OpeningBook::write(outputPath, entries)) {
+        std::fprintf(stderr, "Could not write %s\n", outputPath.c_str());
+        return 1;
+    }
+    std::printf("Wrote %zu positions to %s (%llu unresolved)\n", entries.size(), outputPath.c_str(), static_cast<unsigned long long>(gaps));
+    return 0;
+}